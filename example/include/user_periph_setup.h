@@ -70,12 +70,20 @@
 #endif
 
 #define I2C_LCD_ADDRESS         0x27
+#define I2C_LCD_BUS_KHZ         400     // I2C_SPEED_FAST, see i2c_lcd_cfg
 #define I2C_LCD_NUM_LINES       LCD_TWO_LINES
 #define I2C_LCD_NUM_COLS        24
 #define I2C_LCD_ENTRY_MODE      LCD_ENTRY_INC
 #define I2C_LCD_SHIFT_MODE      LCD_SHIFT_OFF
 #define I2C_LCD_FONT_MODE       LCD_FONT_5x8
 
+// EEPROM on the same bus, the example logs the frame count to it
+#define I2C_EEPROM_DEV_ADDRESS  0x50
+#define I2C_EEPROM_BUS_PRIORITY 2       // above the LCD, see i2c_lcd_bus.h
+#define I2C_EEPROM_DEV_SIZE     0x100   // 24C02
+#define I2C_EEPROM_DEV_PAGE     8
+#define I2C_EEPROM_ADDR_SIZE    I2C_1BYTE_ADDR
+
 /*
  * FUNCTION DECLARATIONS
  ****************************************************************************************
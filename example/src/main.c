@@ -37,6 +37,7 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "arch_system.h"
 #include "user_periph_setup.h"
@@ -45,6 +46,8 @@
 #include "systick.h"
 #include "uart_utils.h"
 #include "i2c_lcd.h"
+#include "i2c_lcd_sprite.h"
+#include "i2c_lcd_eeprom.h"
 
 /*
  * DEFINES
@@ -58,10 +61,16 @@
 uint16_t sequence_count = 0;
 uint8_t ship_pos = 0;
 int ship_dir = 1;
-uint8_t fire_seq = 0;
 uint8_t alien_pos = I2C_LCD_NUM_COLS - 1;
 int alien_dir = -1;
 uint8_t aliens[16] = {0x00, ' ', 0x01, ' ', 0x02, ' ', 0x03, 0x04, 0x05, 0x06, ' ', 0x02, ' ', 0x01, ' ', 0x00};
+// Set by the systick ISR, the frame itself is drawn from the main loop
+volatile bool frame_due = false;
+// The frame count is logged to the EEPROM that shares the bus with the LCD
+i2c_lcd_eeprom_t eeprom = { 
+    .bus = { .address = I2C_EEPROM_DEV_ADDRESS, .priority = I2C_EEPROM_BUS_PRIORITY } 
+};
+uint8_t frame_log[2];
 
 /*
  * FUNCTION DEFINITIONS
@@ -75,6 +84,13 @@ uint8_t aliens[16] = {0x00, ' ', 0x01, ' ', 0x02, ' ', 0x03, 0x04, 0x05, 0x06, '
  */
 void i2c_test(void);
 
+/**
+ ****************************************************************************************
+ * @brief Draws one frame of the sprite demo, called from the main loop
+ ****************************************************************************************
+ */
+static void run_character_sequence(void);
+
 /**
  ****************************************************************************************
  * @brief  Main routine of the I2C EEPROM example
@@ -83,8 +99,16 @@ void i2c_test(void);
 int main (void)
 {
     system_init();
+    i2c_lcd_eeprom_register(&eeprom);
     i2c_test();
-    while(1);
+    while(1) {
+        // EEPROM writes that did not go between two LCD characters run here
+        i2c_lcd_bus_run();
+        if (frame_due) {
+            frame_due = false;
+            run_character_sequence();
+        }
+    }
 }
 
 void wait() {
@@ -130,132 +154,103 @@ void display_all_chars() {
     }    
 }
 
+// Sprite frames, one per tick
+const uint8_t a1_frames[2][8] = {
+    { 0x1F, 0x15, 0x1F, 0x11, 0x0A, 0x00, 0x00, 0x00 },
+    { 0x1F, 0x15, 0x1F, 0x0A, 0x11, 0x00, 0x00, 0x00 },
+};
+const uint8_t a2_frames[2][8] = {
+    { 0x1F, 0x15, 0x1F, 0x15, 0x0A, 0x00, 0x00, 0x00 },
+    { 0x1F, 0x15, 0x0E, 0x15, 0x04, 0x00, 0x00, 0x00 },
+};
+const uint8_t a3_frames[2][8] = {
+    { 0x0E, 0x1B, 0x1F, 0x11, 0x11, 0x00, 0x00, 0x00 },
+    { 0x0E, 0x1B, 0x1F, 0x11, 0x0A, 0x00, 0x00, 0x00 },
+};
+const uint8_t ss1_frames[1][8] = {
+    { 0x10, 0x17, 0x19, 0x19, 0x0F, 0x03, 0x00, 0x00 },
+};
+const uint8_t ss2_frames[2][8] = {
+    { 0x00, 0x1F, 0x19, 0x1F, 0x1F, 0x12, 0x04, 0x00 },
+    { 0x00, 0x1F, 0x19, 0x1F, 0x1F, 0x14, 0x02, 0x00 },
+};
+const uint8_t ss3_frames[2][8] = {
+    { 0x00, 0x1F, 0x13, 0x1F, 0x1F, 0x09, 0x04, 0x00 },
+    { 0x00, 0x1F, 0x13, 0x1F, 0x1F, 0x05, 0x08, 0x00 },
+};
+const uint8_t ss4_frames[1][8] = {
+    { 0x01, 0x1D, 0x13, 0x13, 0x1E, 0x18, 0x00, 0x00 },
+};
+// The ship fires every 6 frames
+const uint8_t ship_frames[6][8] = {
+    { 0x00, 0x04, 0x04, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+    { 0x00, 0x04, 0x04, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+    { 0x00, 0x04, 0x04, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+    { 0x00, 0x04, 0x15, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+    { 0x00, 0x15, 0x04, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+    { 0x11, 0x04, 0x04, 0x0E, 0x1B, 0x1F, 0x15, 0x00 },
+};
+
+// The aliens are put on screen by the demo (several copies each), the ship by the engine
+i2c_lcd_sprite_t sprites[8] = {
+    { a1_frames,   2, 0, 0x00, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { a2_frames,   2, 0, 0x01, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { a3_frames,   2, 0, 0x02, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { ss1_frames,  1, 0, 0x03, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { ss2_frames,  2, 0, 0x04, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { ss3_frames,  2, 0, 0x05, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { ss4_frames,  1, 0, 0x06, I2C_LCD_SPRITE_UNPLACED, 0, false },
+    { ship_frames, 6, 0, 0x07, 0, 1, true },
+};
+
 void create_characters() {
-  bool isEven = sequence_count % 2 ==0;
+    for (uint8_t i = 0; i < 8; i++) {
+        i2c_lcd_sprite_add(&sprites[i]);
+    }
+}
 
-  uint8_t a1[7] = {
-      0xFF,                     // OOOOO
-      0x15,                     // O O O
-      0xFF,                     // OOOOO
-      isEven ? 0x11 : 0x0A,     //  O O 
-      isEven ? 0x0A : 0x11,     // O   O
-      0x00,
-      0x00,
-    };
-    uint8_t a2[7] = {
-      0xFF,                     // OOOOO
-      0x15,                     // O O O
-      isEven ? 0xFF : 0x0E,     //  OOO 
-      0x15,                     // O O O
-      isEven ? 0x0A : 0x04,     //   O
-      0x00,
-      0x00,
-    };
-    uint8_t a3[7] = {
-      0x0E,                     //  OOO
-      0x1B,                     // OO OO
-      0xFF,                     // OOOOO 
-      0x11,                     // O   O
-      isEven ? 0x11 : 0x0A,     //  O O
-      0x00,
-      0x00,
-    };
-    
-    uint8_t ss1[7] = {
-      0x10,                     // O   
-      0x17,                     // O OOO
-      0x19,                     // OO  O 
-      0x19,                     // OO  O
-      0x0F,                     //  OOOO
-      0x03,                     //    OO
-      0x00,
-    };
-    
-    uint8_t ss2[7] = {
-      0x00,                     // 
-      0xFF,                     // OOOOO
-      0x19,                     // OO  O
-      0xFF,                     // OOOOO 
-      0xFF,                     // OOOOO
-      isEven ? 0x12 : 0x14,     // O O
-      isEven ? 0x04 : 0x02,     //    O
-    };
-    
-    uint8_t ss3[7] = {
-      0x00,                     // OOOOO    
-      0xFF,                     // OOOOO
-      0x13,                     // O  OO
-      0xFF,                     // OOOOO
-      0xFF,                     // OOOOO
-      isEven ? 0x09 : 0x05,     //   O O
-      isEven ? 0x04 : 0x08,     //  O  
-    };
-    
-    
-    uint8_t ss4[7] = {
-      0x01,                     //     O
-      0x1D,                     // OOO O
-      0x13,                     // O  OO 
-      0x13,                     // O  OO
-      0x1E,                     // OOOO
-      0x18,                     // OO
-      0x00,
-    };
-    
-    
-    uint8_t s1[7] = {
-      fire_seq == 5 ? 0x11 : 0x00,      //   
-      fire_seq == 4 ? 0x15 : 0x04,      //   O
-      fire_seq == 3 ? 0x15 : 0x04,      //   O 
-      0x0E,                             //  O O
-      0x1B,                             // OO OO
-      0xFF,                             // OOOOO
-      0x15,                             // O O O
-    };
-    
-    i2c_lcd_create_char(0, a1);
-    i2c_lcd_create_char(1, a2);
-    i2c_lcd_create_char(2, a3);
-    i2c_lcd_create_char(3, ss1);
-    i2c_lcd_create_char(4, ss2);
-    i2c_lcd_create_char(5, ss3);
-    i2c_lcd_create_char(6, ss4);
-    i2c_lcd_create_char(7, s1);
+// Keep the ISR short, the bus transfers and UART printing happen in the main loop
+static void frame_timer_isr(void) {
+    frame_due = true;
 }
 
 static void run_character_sequence(void) {
-    if(sequence_count > I2C_LCD_NUM_COLS - 1) {
-        i2c_lcd_set_cursor(0, 0);
-        i2c_lcd_clear_line(I2C_LCD_NUM_COLS);
+    uint8_t row[I2C_LCD_NUM_COLS];
+    uint8_t count = sequence_count < 16 ? sequence_count + 1 : 16;
+    uint32_t bytes = 0;
+    char message[32];
+    
+    // Only the cells of the formation that changed are written
+    for (uint8_t i = 0; i < I2C_LCD_NUM_COLS; i++) {
+        row[i] = ' ';
+    }
+    for (uint8_t i = 0; i < count && alien_pos + i < I2C_LCD_NUM_COLS; i++) {
+        row[alien_pos + i] = aliens[i];
     }
+    i2c_lcd_update(0, 0, row, I2C_LCD_NUM_COLS);
     
-    i2c_lcd_set_cursor(alien_pos, 0);
-    i2c_lcd_print(aliens, sequence_count < 16 ? sequence_count + 1 : 16);
+    i2c_lcd_sprite_move(&sprites[7], ship_pos, 1);
+    i2c_lcd_sprite_tick(&bytes);
+    snprintf(message, sizeof(message), "Frame %u: %lu bytes\n\r", sequence_count, 
+        (unsigned long)bytes);
+    printf_string(UART, message);
     
-    if(sequence_count >= 16 && sequence_count < I2C_LCD_NUM_COLS) {
-        i2c_lcd_set_cursor(alien_pos + 16, 0);
-        i2c_lcd_clear_line(sequence_count - 16 + 1);
+    // Skipped if the last write has not run yet, frame_log must not change under it
+    if (!i2c_lcd_eeprom_busy(&eeprom)) {
+        frame_log[0] = sequence_count >> 8;
+        frame_log[1] = sequence_count & 0xFF;
+        i2c_lcd_eeprom_write(&eeprom, frame_log, 0, sizeof(frame_log));
     }
     
-    i2c_lcd_set_cursor(0, 1);
-    i2c_lcd_clear_line(I2C_LCD_NUM_COLS);
-    i2c_lcd_set_cursor(ship_pos, 1);
-    uint8_t ship[1] = {0x07};
-    i2c_lcd_print(ship, 1);
-    create_characters();
     ship_pos += ship_dir;
     alien_pos += alien_dir;
     sequence_count++;
-    fire_seq++;
     if(ship_pos == I2C_LCD_NUM_COLS - 1) {
         ship_dir = -1;
     }
     if(ship_pos == 0) {
         ship_dir = 1;
     }
-    if(fire_seq == 6) {
-        fire_seq = 0;
-    }
     if(alien_pos == 0) {
         alien_dir = 1;
     }
@@ -265,6 +260,7 @@ static void run_character_sequence(void) {
     if(sequence_count < I2C_LCD_NUM_COLS * 2) {
         systick_start(1000000, 1);
     } else {
+        i2c_lcd_sprite_remove_all();
         end_demo();
     }
 }
@@ -353,7 +349,7 @@ void i2c_test(void)
     wait();
     display_message(buffer7, 17, 0);
     create_characters();
-    systick_register_callback(run_character_sequence);
+    systick_register_callback(frame_timer_isr);
     systick_start(1000000, 1);
 }
 
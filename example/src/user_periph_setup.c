@@ -23,6 +23,7 @@
 #include "i2c.h"
 #include "i2c_eeprom.h"
 #include "syscntl.h"
+#include "arch.h"
 #include "i2c_lcd.h"
 
 /*
@@ -30,6 +31,9 @@
  ****************************************************************************************
  */
 
+// Zeroed at cold boot (and MCU reset) only, periph_init also runs on every wakeup
+static bool lcd_started __SECTION_ZERO("retention_mem_area0");
+
 static void set_pad_functions(void)
 {
 /*
@@ -70,7 +74,7 @@ static const i2c_cfg_t i2c_lcd_cfg = {
     .clock_cfg.fs_hcnt = I2C_FS_SCL_HCNT_REG_RESET,
     .clock_cfg.fs_lcnt = I2C_FS_SCL_LCNT_REG_RESET,
     .restart_en = I2C_RESTART_ENABLE,
-    .speed = I2C_SPEED_FAST,
+    .speed = I2C_SPEED_FAST,        // keep I2C_LCD_BUS_KHZ in step
     .mode = I2C_MODE_MASTER,
     .addr_mode = I2C_ADDRESSING_7B,
     .address = I2C_LCD_ADDRESS,
@@ -78,6 +82,27 @@ static const i2c_cfg_t i2c_lcd_cfg = {
     .rx_fifo_level = 1,
 };
 
+// Configuration structs for the EEPROM, the controller is shared with the LCD
+static const i2c_cfg_t i2c_eeprom_bus_cfg = {
+    .clock_cfg.ss_hcnt = I2C_SS_SCL_HCNT_REG_RESET,
+    .clock_cfg.ss_lcnt = I2C_SS_SCL_LCNT_REG_RESET,
+    .clock_cfg.fs_hcnt = I2C_FS_SCL_HCNT_REG_RESET,
+    .clock_cfg.fs_lcnt = I2C_FS_SCL_LCNT_REG_RESET,
+    .restart_en = I2C_RESTART_ENABLE,
+    .speed = I2C_SPEED_FAST,
+    .mode = I2C_MODE_MASTER,
+    .addr_mode = I2C_ADDRESSING_7B,
+    .address = I2C_EEPROM_DEV_ADDRESS,
+    .tx_fifo_level = 1,
+    .rx_fifo_level = 1,
+};
+
+static const i2c_eeprom_cfg_t i2c_eeprom_cfg = {
+    .size = I2C_EEPROM_DEV_SIZE,
+    .page_size = I2C_EEPROM_DEV_PAGE,
+    .address_size = I2C_EEPROM_ADDR_SIZE,
+};
+
 void periph_init(void)
 {
 #if defined (__DA14531__)
@@ -98,6 +123,10 @@ void periph_init(void)
 
     // Initialize I2C
     i2c_init(&i2c_lcd_cfg);
+    // The target is the config address again
+    i2c_lcd_bus_reset();
+    // Only stores the EEPROM settings, i2c_eeprom_initialize would run i2c_init again
+    i2c_eeprom_configure(&i2c_eeprom_bus_cfg, &i2c_eeprom_cfg);
 
     // Set pad functionality
     set_pad_functions();
@@ -105,6 +134,12 @@ void periph_init(void)
     // Enable the pads
     GPIO_set_pad_latch_en(true);
     
-    // Init I2C LCD
-    i2c_lcd_init();
+    if (!lcd_started) {
+        // Init I2C LCD, skips the power up sequence if the LCD kept its state
+        i2c_lcd_init_warm(NULL);
+        lcd_started = true;
+    } else {
+        // Wakeup, the driver state is retained and the LCD supply is not gated
+        i2c_lcd_wake(I2C_LCD_POWER_KEPT, NULL);
+    }
 }
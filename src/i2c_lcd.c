@@ -30,10 +30,13 @@
  ********************************************************************************
  */
 
+#include <stddef.h>
+#include "compiler.h"
 #include "i2c.h"
 #include "user_periph_setup.h"
 #include "systick.h"
 #include "i2c_lcd.h"
+#include "i2c_lcd_bus.h"
 
 /**
  ****************************************************************************************
@@ -53,6 +56,14 @@
 #define I2C_LCD_NUM_COLS    16
 #endif
 
+#ifndef I2C_LCD_NUM_ROWS
+#if I2C_LCD_NUM_LINES == LCD_TWO_LINES
+#define I2C_LCD_NUM_ROWS    2
+#else
+#define I2C_LCD_NUM_ROWS    1
+#endif
+#endif
+
 #ifndef I2C_LCD_ENTRY_MODE
 #define I2C_LCD_ENTRY_MODE  LCD_ENTRY_INC
 #endif
@@ -65,251 +76,2341 @@
 #define I2C_LCD_FONT_MODE   LCD_FONT_5x8
 #endif
 
+// Expander the LCD is wired to
+#ifndef I2C_LCD_BACKEND
+#define I2C_LCD_BACKEND     I2C_LCD_PCF8574
+#endif
+
+// Expander pins of the LCD lines. D4-D7 are on 4 pins in a row starting at 
+// I2C_LCD_DATA_SHIFT, with the MCP23017 D0-D7 are port A and these pins are on 
+// port B. A pin that is not wired is 0x00.
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+// Adafruit I2C/SPI backpack, RW is tied low
+#ifndef I2C_LCD_PIN_RS
+#define I2C_LCD_PIN_RS      0x02
+#endif
+#ifndef I2C_LCD_PIN_RW
+#define I2C_LCD_PIN_RW      0x00
+#endif
+#ifndef I2C_LCD_PIN_E
+#define I2C_LCD_PIN_E       0x04
+#endif
+#ifndef I2C_LCD_PIN_BL
+#define I2C_LCD_PIN_BL      0x80
+#endif
+#ifndef I2C_LCD_DATA_SHIFT
+#define I2C_LCD_DATA_SHIFT  3
+#endif
+#else
+// Common PCF8574 backpack (and the MCP23017 port B)
+#ifndef I2C_LCD_PIN_RS
+#define I2C_LCD_PIN_RS      0x01
+#endif
+#ifndef I2C_LCD_PIN_RW
+#define I2C_LCD_PIN_RW      0x02
+#endif
+#ifndef I2C_LCD_PIN_E
+#define I2C_LCD_PIN_E       0x04
+#endif
+#ifndef I2C_LCD_PIN_BL
+#define I2C_LCD_PIN_BL      0x08
+#endif
+#ifndef I2C_LCD_DATA_SHIFT
+#define I2C_LCD_DATA_SHIFT  4
+#endif
+#endif
+
+// Number of times a NACKed expander byte is sent again before giving up
+#ifndef I2C_LCD_RETRIES
+#define I2C_LCD_RETRIES     3
+#endif
+
+// Cells read back by one i2c_lcd_scrub call
+#ifndef I2C_LCD_SCRUB_CELLS
+#define I2C_LCD_SCRUB_CELLS 8
+#endif
+
+// Minimum time between two i2c_lcd_scrub reads
+#ifndef I2C_LCD_SCRUB_PERIOD_MS
+#define I2C_LCD_SCRUB_PERIOD_MS 100
+#endif
+
+// I2C clock in kHz, must match the speed the I2C block is set up with: 100 for 
+// I2C_SPEED_STANDARD, 400 for I2C_SPEED_FAST, 1000 for fast-plus counts. The 
+// waits are cut by the time the bus takes, so a too high value is the safe one
+#ifndef I2C_LCD_BUS_KHZ
+#define I2C_LCD_BUS_KHZ     1000
+#endif
+
+// Execution time of a character or instruction (37us + 4us in the datasheet), 
+// with room for the slower HD44780 clones
+#ifndef I2C_LCD_EXEC_US
+#define I2C_LCD_EXEC_US     50
+#endif
+
+// Characters (address commands included) one DMA frame can hold
+#ifndef I2C_LCD_DMA_CHARS
+#define I2C_LCD_DMA_CHARS   24
+#endif
+
+// Time one byte takes on the wire inside a DMA frame (8 bits and the ACK)
+#ifndef I2C_LCD_DMA_WORD_US
+#define I2C_LCD_DMA_WORD_US (9000 / I2C_LCD_BUS_KHZ)
+#endif
+
+// Priority of the LCD on a shared bus (see i2c_lcd_bus.h), jobs of clients 
+// with a higher priority run between two characters of an LCD transfer
+#ifndef I2C_LCD_BUS_PRIORITY
+#define I2C_LCD_BUS_PRIORITY 0
+#endif
+
+// Placement of the retained state, must survive sleep and MCU resets
+#ifndef I2C_LCD_RETAINED
+#ifdef __SECTION_ZERO
+#define I2C_LCD_RETAINED    __SECTION_ZERO("retention_mem_area_uninit")
+#else
+#define I2C_LCD_RETAINED
+#endif
+#endif
+
+// Marks the retained state as valid, changes with its layout
+#define I2C_LCD_MARKER      (0x4C434400 ^ sizeof(i2c_lcd_retained_t))
+
+// Expander lines, from the pin config above
+#define DATA_REGR           I2C_LCD_PIN_RS // data register select 
+#define LCD_READ            I2C_LCD_PIN_RW // RW line of the expander
+#define LCD_ENABLE          I2C_LCD_PIN_E  // E line of the expander
+#define NUM_ROWS            I2C_LCD_NUM_ROWS
+
+// Expander ports and registers (MCP23017 registers with IOCON.BANK = 0)
+#define LCD_8BIT_BUS        (I2C_LCD_BACKEND == I2C_LCD_MCP23017)
+#define LCD_CAN_READ        (I2C_LCD_PIN_RW != 0)
+#define DATA_PINS           (0x0F << I2C_LCD_DATA_SHIFT)
+#define DATA_NIBBLE(n)      (((n) & 0x0F) << I2C_LCD_DATA_SHIFT)
+#define BACKLIGHT_PIN(on)   ((on) ? I2C_LCD_PIN_BL : 0x00)
+#define MCP_IOCON_SEQOP     0x20 // register pointer does not increment (23017: toggles A/B)
+#define MCP23008_IODIR      0x00
+#define MCP23008_IOCON      0x05
+#define MCP23008_GPIO       0x09
+#define MCP23017_IODIRA     0x00
+#define MCP23017_IOCON      0x0A
+#define MCP23017_GPIOA      0x12
+#define MCP23017_GPIOB      0x13
+
+// Expander bytes from one enable falling edge to the next and per character. 
+// The MCP23017 strobe is port B (control), A (data), B (E high), A, B (E low).
+#if LCD_8BIT_BUS
+#define STROBE_BYTES        5
+#define CHAR_BYTES          5
+#else
+#define STROBE_BYTES        3
+#define CHAR_BYTES          6
+#endif
+
+// Time of one expander byte on the wire (START, address, STOP and bus free 
+// included): a transfer per byte, a register byte with the MCP23008 and a 
+// transfer per character with the MCP23017
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+#define WIRE_BYTE_US        (29000 / I2C_LCD_BUS_KHZ)
+#elif I2C_LCD_BACKEND == I2C_LCD_MCP23017
+#define WIRE_BYTE_US        (13000 / I2C_LCD_BUS_KHZ)
+#else
+#define WIRE_BYTE_US        (20000 / I2C_LCD_BUS_KHZ)
+#endif
+
+// A DMA frame to the MCP23008 starts with the GPIO register (IOCON.SEQOP set)
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+#define DMA_PREFIX_WORDS    1
+#else
+#define DMA_PREFIX_WORDS    0
+#endif
+
+// Idle words after a character in a DMA frame: the next enable pulse comes 3 
+// words later and must not come before the character has been executed
+#define DMA_EXEC_WORDS      ((I2C_LCD_EXEC_US + I2C_LCD_DMA_WORD_US - 1) / I2C_LCD_DMA_WORD_US)
+#define DMA_IDLE_WORDS      (DMA_EXEC_WORDS > 3 ? DMA_EXEC_WORDS - 3 : 0)
+#define DMA_CHAR_WORDS      (6 + DMA_IDLE_WORDS)
+
 // Private state variables
-uint8_t _backlight          = 0x00;
-uint8_t _display            = LCD_DISPLAY_ON;
-uint8_t _cursor             = 0x00;
-uint8_t _blink              = 0x00;
+uint8_t _backlight_out      = 0x00;  // backlight bit put on the expander (pattern aware)
 uint8_t _shift_display      = 0x00;
 uint8_t _shift_right        = LCD_SHIFT_RIGHT;
-uint8_t _entry_mode         = I2C_LCD_ENTRY_MODE;
-uint8_t _shift_mode         = I2C_LCD_SHIFT_MODE;
+
+/**
+ ******************************************************************************
+ * State that describes what should be on the LCD. It is kept in retention RAM 
+ * (not cleared by the boot code) so that after an MCU reset or a wakeup the 
+ * driver can tell that the LCD is already set up and skip the power up 
+ * sequence, see i2c_lcd_init_warm. [marker] is only valid once a full 
+ * initialization has completed.
+ ******************************************************************************
+ */
+typedef struct {
+    uint32_t marker;
+    uint8_t backlight;
+    uint8_t display;
+    uint8_t cursor;
+    uint8_t blink;
+    uint8_t entry_mode;
+    uint8_t shift_mode;
+    uint8_t ac;                         // address counter (DDRAM or CGRAM)
+    bool    ac_cgram;                   // true after a CGRAM address was set
+    int8_t  display_shift;              // display shift, positive is to the right
+    uint8_t cgram_used;                 // bit per CGRAM location that has been written
+    uint8_t ddram[LCD_DDRAM_SIZE];      // RAM copy of the screen
+    uint8_t cgram[LCD_CGRAM_SIZE];      // RAM copy of the custom characters
+} i2c_lcd_retained_t;
+
+I2C_LCD_RETAINED i2c_lcd_retained_t _ret;
+
+// What the controller is known to hold, used to drop redundant commands
+bool    _ac_valid           = false; // false when the controller may not match _ret.ac
+uint8_t _display_sent       = 0xFF;  // last display control command sent
+uint8_t _entry_sent         = 0xFF;  // last entry mode command sent
+uint8_t _backlight_sent     = 0xFF;  // backlight bit carried by the last byte sent
+uint8_t _port               = 0x00;  // last byte written to the expander port
+uint8_t _batch_depth        = 0;
+bool    _display_pending    = false;
+bool    _backlight_pending  = false;
+bool    _resync_needed      = false; // an abort left the controller out of phase
+bool    _resyncing          = false;
+
+// Backlight pattern generator (see i2c_lcd_backlight_pattern)
+uint32_t _bl_pattern        = 0;
+uint8_t  _bl_length         = 0;     // 0 when no pattern is running
+uint16_t _bl_step_ms        = 0;
+uint8_t  _bl_repeat         = 0;
+uint32_t _bl_start_ms       = 0;
+bool     _bl_started        = false;
+i2c_lcd_stats_t _stats;
+
+// Deferred cells (see i2c_lcd_defer), compared with _ret.ddram to find pending cells
+uint8_t  _fb[LCD_DDRAM_SIZE];
+uint8_t  _fb_priority[LCD_DDRAM_SIZE / 8];  // bit per cell flushed first
+bool     _fb_valid          = false; // false until _fb is copied from _ret.ddram
+uint8_t  _fb_resume         = 0;     // cell the next flush starts from
+
+// DMA frame (see i2c_lcd_update_dma), encoded in place and handed to the engine
+uint16_t _dma_frame[DMA_PREFIX_WORDS + I2C_LCD_DMA_CHARS * DMA_CHAR_WORDS];
+volatile bool _dma_busy     = false; // a frame is on the bus
+volatile bool _group_ok     = false; // the last group frame was taken
+#if defined (CFG_I2C_DMA_SUPPORT)
+i2c_lcd_dma_engine_t _dma_engine = i2c_master_transmit_buffer_dma;
+#else
+i2c_lcd_dma_engine_t _dma_engine = i2c_lcd_dma_standin;
+#endif
+
+// Callback for the long waits (see i2c_lcd_set_yield)
+i2c_lcd_yield_t _yield      = NULL;
+uint32_t _yield_min_us      = 0;
+
+// The LCD on the shared bus
+i2c_lcd_bus_client_t _bus_client = { 
+    .address = I2C_LCD_ADDRESS, 
+    .priority = I2C_LCD_BUS_PRIORITY 
+};
+
+// DDRAM scrub (see i2c_lcd_scrub)
+uint8_t  _scrub_index       = 0;     // next cell to read back, lines one after the other
+uint32_t _scrub_last_ms     = 0;
+bool     _scrub_started     = false;
 
 /*-------------------------------------------------------------------------- */
 /* Private Function Declarations                                             */ 
 /*---------------------------------------------------------------------------*/
-uint16_t _i2c_lcd_send(
+i2c_lcd_status_t _i2c_lcd_send(
     const uint8_t *data, 
     uint16_t len, 
     uint8_t mode, 
     uint8_t rs
     );
 static void _i2c_lcd_set_address(void);
-void _i2c_send_and_wait_8bit(uint8_t byte, uint32_t us);
-uint8_t _i2c_lcd_display_cmd(void);
+i2c_lcd_status_t _i2c_send_and_wait_8bit(uint8_t byte, uint32_t us);
+static uint8_t _i2c_lcd_display_cmd(void);
+static uint8_t _i2c_lcd_function_cmd(void);
 void _i2c_lcd_init(void);
-void _i2c_lcd_command(const uint8_t byte);
-uint8_t _i2c_lcd_entry_mode_cmd(void);
+i2c_lcd_status_t _i2c_lcd_command(const uint8_t byte);
+static uint8_t _i2c_lcd_entry_mode_cmd(void);
+static i2c_lcd_status_t _i2c_lcd_update_display(void);
+static i2c_lcd_status_t _i2c_lcd_update_backlight(void);
+static i2c_lcd_status_t _i2c_lcd_write_port(uint8_t port);
+static i2c_lcd_status_t _i2c_lcd_read_port(uint8_t *port);
+static i2c_lcd_status_t _i2c_lcd_write_reg(uint8_t reg, uint8_t value);
+static i2c_lcd_status_t _i2c_lcd_expander_setup(void);
+static i2c_lcd_status_t _i2c_lcd_data_direction(bool input);
+static i2c_lcd_status_t _i2c_lcd_read(uint8_t rs, uint8_t *data, uint16_t len);
+static bool _i2c_lcd_probe(void);
+static i2c_lcd_status_t _i2c_lcd_update_entry_mode(void);
+static i2c_lcd_status_t _i2c_lcd_write_data(const uint8_t *data, uint16_t len);
+static i2c_lcd_status_t _i2c_lcd_restore_ac(void);
+static i2c_lcd_status_t _i2c_lcd_repaint(bool cleared);
+static i2c_lcd_status_t _i2c_lcd_power_up(void);
+static void _i2c_lcd_wait(uint32_t us);
+static void _i2c_lcd_spin(uint32_t us);
+static void _i2c_lcd_advance_ac(void);
+static uint8_t _i2c_lcd_ddram_index(uint8_t address);
+static uint8_t _i2c_lcd_address(uint8_t col, uint8_t row);
+static i2c_lcd_status_t _i2c_lcd_goto(uint8_t address);
+static i2c_lcd_status_t _i2c_lcd_write_cgram(uint8_t address, const uint8_t *data, 
+    uint8_t len);
+static uint8_t _i2c_lcd_span(void);
+static uint32_t _i2c_lcd_byte_us(uint16_t index);
+static uint32_t _i2c_lcd_slack_us(uint16_t index);
+static uint32_t _i2c_lcd_char_us(void);
+static uint8_t _i2c_lcd_ddram_address(uint8_t index);
+static i2c_lcd_status_t _i2c_lcd_flush_run(uint8_t index, uint8_t len);
+static void _i2c_lcd_store_data(const uint8_t *data, uint16_t len);
+void i2c_lcd_get_8bit_cmd(uint8_t byte, uint8_t buffer[STROBE_BYTES], uint8_t rs);
+void i2c_lcd_get_4bit_cmd(uint8_t byte, uint8_t buffer[6], uint8_t rs);
+#if !LCD_8BIT_BUS
+static uint16_t _i2c_lcd_encode(uint16_t words, uint8_t byte, uint8_t rs);
+static void _i2c_lcd_dma_start(uint16_t words);
+static void _i2c_lcd_dma_done(void *cb_data, uint16_t len, bool success);
+static uint16_t _i2c_lcd_group_frame(void);
+static uint16_t _i2c_lcd_group_encode(i2c_lcd_group_t *group, uint16_t words, 
+    uint8_t byte, uint8_t rs);
+static i2c_lcd_status_t _i2c_lcd_group_send(i2c_lcd_group_t *group, uint16_t words);
+static void _i2c_lcd_group_done(void *cb_data, uint16_t len, bool success);
+#endif
+
+/*-------------------------------------------------------------------------- */
+/* LCD API Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+i2c_lcd_status_t i2c_lcd_init() {
+    i2c_lcd_status_t status;
+    
+    // Start from the default settings unless they survived a reset
+    if (_ret.marker != I2C_LCD_MARKER) {
+        _ret.backlight = LCD_BACKLIGHT_OFF;
+        _ret.display = LCD_DISPLAY_ON;
+        _ret.cursor = 0x00;
+        _ret.blink = 0x00;
+        _ret.entry_mode = I2C_LCD_ENTRY_MODE;
+        _ret.shift_mode = I2C_LCD_SHIFT_MODE;
+        _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+    }
+    _ret.marker = 0;
+    
+    status = _i2c_lcd_power_up();
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    
+    // Power up cleared DDRAM and left CGRAM undefined, nothing to repaint there
+    for (uint8_t i = 0; i < LCD_DDRAM_SIZE; i++) {
+        _ret.ddram[i] = ' ';
+    }
+    _ret.cgram_used = 0x00;
+    _ret.display_shift = 0;
+    _ret.ac = 0x00;
+    _ret.ac_cgram = false;
+    _ac_valid = true;
+    _fb_valid = false;
+    
+    // Entry mode set is the final instruction
+    status = _i2c_lcd_update_entry_mode();
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    
+    // Settings that survived a reset
+    status = _i2c_lcd_update_display();
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    
+    // This is not in the instructions but I figure its a nice thing to do.
+    status = i2c_lcd_backlight_on();
+    if (status == I2C_LCD_OK) {
+        _ret.marker = I2C_LCD_MARKER;
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Skips the power up sequence when the retained state is valid and the 
+ * controller answers a DDRAM address read back in 4bit mode. A controller 
+ * that does not answer is resynced and probed again before falling back to 
+ * i2c_lcd_init.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_init_warm(i2c_lcd_start_t *start) {
+    i2c_lcd_status_t status;
+    i2c_lcd_start_t path = I2C_LCD_START_COLD;
+    
+    if (_ret.marker == I2C_LCD_MARKER) {
+        _i2c_lcd_set_address();
+        _ac_valid = false;
+        _display_sent = 0xFF;
+        _entry_sent = 0xFF;
+        _backlight_sent = 0xFF;
+        _resync_needed = false;
+        _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+        
+        if (_i2c_lcd_expander_setup() == I2C_LCD_OK && _i2c_lcd_probe()) {
+            path = I2C_LCD_START_WARM;
+            status = _i2c_lcd_update_display();
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_entry_mode();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_backlight();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_repaint(false);
+            }
+        } else {
+            path = I2C_LCD_START_RESYNC;
+            status = i2c_lcd_resync();
+            if (status == I2C_LCD_OK && !_i2c_lcd_probe()) {
+                status = I2C_LCD_ERR_ABORT;
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_restore_ac();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_backlight();
+            }
+        }
+        if (status != I2C_LCD_OK) {
+            path = I2C_LCD_START_COLD;
+        }
+    }
+    
+    if (start != NULL) {
+        *start = path;
+    }
+    if (path != I2C_LCD_START_COLD) {
+        return I2C_LCD_OK;
+    }
+    return i2c_lcd_init();
+}
+
+/**
+ ******************************************************************************
+ * Restores the LCD after sleep with as few writes as possible: nothing when 
+ * it kept power, a resync when it is out of step and a power up followed by a 
+ * repaint of the used glyphs and the non blank cells when it lost power.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_wake(i2c_lcd_power_t power, i2c_lcd_restore_t *restore) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    i2c_lcd_restore_path_t path = I2C_LCD_RESTORE_NONE;
+    uint32_t bytes = _stats.bus_bytes;
+    uint32_t us = _stats.wait_us;
+    
+    if (_ret.marker != I2C_LCD_MARKER) {
+        // Nothing to restore from
+        path = I2C_LCD_RESTORE_FULL;
+        status = i2c_lcd_init();
+    } else if (power != I2C_LCD_POWER_KEPT) {
+        _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+        if (power == I2C_LCD_POWER_UNKNOWN) {
+            if (_i2c_lcd_expander_setup() == I2C_LCD_OK && _i2c_lcd_probe()) {
+                // The probe moved the address counter, the next write restores it
+                path = I2C_LCD_RESTORE_NONE;
+            } else {
+                path = I2C_LCD_RESTORE_RESYNC;
+                status = i2c_lcd_resync();
+                if (status == I2C_LCD_OK && !_i2c_lcd_probe()) {
+                    path = I2C_LCD_RESTORE_FULL;
+                }
+            }
+        } else {
+            path = I2C_LCD_RESTORE_FULL;
+        }
+        
+        if (path == I2C_LCD_RESTORE_FULL) {
+            _ret.marker = 0;
+            status = _i2c_lcd_power_up();
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_entry_mode();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_display();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_update_backlight();
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_repaint(true);
+            }
+            if (status == I2C_LCD_OK) {
+                _ret.marker = I2C_LCD_MARKER;
+            }
+        }
+    }
+    
+    if (restore != NULL) {
+        restore->path = path;
+        restore->bytes = _stats.bus_bytes - bytes;
+        restore->us = _stats.wait_us - us;
+    }
+    return status;
+}
+
+i2c_lcd_status_t i2c_lcd_print(uint8_t *data, uint8_t length) {
+    return _i2c_lcd_write_data(data, length);
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_off() {
+    _ret.backlight = LCD_BACKLIGHT_OFF;
+    if (_bl_length == 0) {
+        _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+        return _i2c_lcd_update_backlight();
+    }
+    return I2C_LCD_OK;
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_on() {
+    _ret.backlight = LCD_BACKLIGHT_ON;
+    if (_bl_length == 0) {
+        _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+        return _i2c_lcd_update_backlight();
+    }
+    return I2C_LCD_OK;
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_pattern(uint32_t pattern, uint8_t length, 
+    uint16_t step_ms, uint8_t repeat) {
+    if (length == 0 || length > 32 || step_ms == 0) {
+        return i2c_lcd_backlight_pattern_stop();
+    }
+    _bl_pattern = pattern;
+    _bl_length = length;
+    _bl_step_ms = step_ms;
+    _bl_repeat = repeat;
+    // The first tick marks the start of the pattern
+    _bl_started = false;
+    return I2C_LCD_OK;
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_blink(uint16_t period_ms) {
+    // One step on, one step off
+    return i2c_lcd_backlight_pattern(0x01, 2, period_ms / 2, 0);
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_pattern_stop() {
+    _bl_length = 0;
+    _backlight_out = BACKLIGHT_PIN(_ret.backlight);
+    return _i2c_lcd_update_backlight();
+}
+
+i2c_lcd_status_t i2c_lcd_backlight_tick(uint32_t now_ms) {
+    if (_bl_length == 0) {
+        return I2C_LCD_OK;
+    }
+    if (!_bl_started) {
+        _bl_start_ms = now_ms;
+        _bl_started = true;
+    }
+    uint32_t step = (now_ms - _bl_start_ms) / _bl_step_ms;
+    if (_bl_repeat > 0 && step / _bl_length >= _bl_repeat) {
+        return i2c_lcd_backlight_pattern_stop();
+    }
+    _backlight_out = BACKLIGHT_PIN((_bl_pattern >> (step % _bl_length)) & 0x01);
+    // Only transitions reach the bus
+    if (_backlight_out != _backlight_sent) {
+        return _i2c_lcd_update_backlight();
+    }
+    return I2C_LCD_OK;
+}
+
+i2c_lcd_status_t i2c_lcd_clear() {
+    i2c_lcd_status_t status = _i2c_lcd_command(0x01);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    _i2c_lcd_wait(2000);
+    // Clear also resets the address counter and forces the entry mode to increment
+    for (uint8_t i = 0; i < LCD_DDRAM_SIZE; i++) {
+        _ret.ddram[i] = ' ';
+    }
+    _ret.display_shift = 0;
+    _ret.ac = 0x00;
+    _ret.ac_cgram = false;
+    _ac_valid = true;
+    _fb_valid = false;
+    _entry_sent |= LCD_ENTRY_INC;
+    return _i2c_lcd_update_entry_mode();
+}
+
+i2c_lcd_status_t i2c_lcd_clear_line(uint8_t length) {
+    // 40 space buffer because 40 is the max length of any display we'll use
+    uint8_t buffer[] = "                                        ";
+    return _i2c_lcd_write_data(buffer, length);
+}
+
+i2c_lcd_status_t i2c_lcd_home() {
+    i2c_lcd_status_t status = _i2c_lcd_command(0x02);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    _i2c_lcd_wait(2000);
+    _ret.display_shift = 0;
+    _ret.ac = 0x00;
+    _ret.ac_cgram = false;
+    _ac_valid = true;
+    return I2C_LCD_OK;
+}
+
+i2c_lcd_status_t i2c_lcd_set_cursor(uint8_t col, uint8_t row) {
+    return _i2c_lcd_goto(_i2c_lcd_address(col, row));
+}
+
+/**
+ ******************************************************************************
+ * Compares [data] to the RAM copy of the screen and writes the runs of cells 
+ * that differ. A run goes on over a single unchanged cell because a new 
+ * address costs as much as writing the cell again. Runs need the address 
+ * counter to increment without shifting the display, in the other entry 
+ * modes every changed cell gets its own address.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_update(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    uint8_t address = _i2c_lcd_address(col, row);
+    // Stay on the line, the address counter jumps at its end
+    uint8_t span = NUM_LINES == LCD_TWO_LINES ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    uint8_t room = span - _i2c_lcd_ddram_index(address) % span;
+    if (length > room) {
+        length = room;
+    }
+    bool runs = _ret.entry_mode == LCD_ENTRY_INC && _ret.shift_mode == LCD_SHIFT_OFF;
+    uint8_t start = 0;
+    while (start < length && status == I2C_LCD_OK) {
+        if (_ret.ddram[_i2c_lcd_ddram_index(address + start)] == data[start]) {
+            _stats.cells_elided++;
+            start++;
+            continue;
+        }
+        uint8_t end = start + 1;
+        while (runs && end < length && 
+            (_ret.ddram[_i2c_lcd_ddram_index(address + end)] != data[end] || 
+            (end + 1 < length && 
+            _ret.ddram[_i2c_lcd_ddram_index(address + end + 1)] != data[end + 1]))) {
+            end++;
+        }
+        status = _i2c_lcd_goto(address + start);
+        if (status == I2C_LCD_OK) {
+            status = _i2c_lcd_write_data(&data[start], end - start);
+        }
+        start = end;
+    }
+    return status;
+}
+
+i2c_lcd_status_t i2c_lcd_shift_right() {
+    i2c_lcd_status_t status = _i2c_lcd_command(0x1C);
+    if (status == I2C_LCD_OK) {
+        _ret.display_shift = (_ret.display_shift + 1) % 40;
+    }
+    return status;
+};
+
+i2c_lcd_status_t i2c_lcd_shift_left(){
+    i2c_lcd_status_t status = _i2c_lcd_command(0x18);
+    if (status == I2C_LCD_OK) {
+        _ret.display_shift = (_ret.display_shift - 1) % 40;
+    }
+    return status;
+};
+
+i2c_lcd_status_t i2c_lcd_display_on() {
+    _ret.display = LCD_DISPLAY_ON;
+    return _i2c_lcd_update_display();
+};
+i2c_lcd_status_t i2c_lcd_display_off() {
+    _ret.display = 0x00;
+    return _i2c_lcd_update_display();
+};
+i2c_lcd_status_t i2c_lcd_blink_on() {
+    _ret.blink = LCD_BLINK_ON;
+    return _i2c_lcd_update_display();
+};
+i2c_lcd_status_t i2c_lcd_blink_off() {
+    _ret.blink = 0x00;
+    return _i2c_lcd_update_display();
+};
+i2c_lcd_status_t i2c_lcd_cursor_on() {
+    _ret.cursor = LCD_CURSOR_ON;
+    return _i2c_lcd_update_display();
+};
+i2c_lcd_status_t i2c_lcd_cursor_off() {
+    _ret.cursor = 0x00;
+    return _i2c_lcd_update_display();
+};
+/**
+ ******************************************************************************
+ * A location that has not been used yet is written whole, otherwise only the 
+ * runs of rows that differ from the RAM copy are written (a run goes on over 
+ * a single unchanged row, like in i2c_lcd_update). Nothing is written when 
+ * the location already holds the glyph.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_create_char(uint8_t location, const uint8_t *charmap) {
+    location &= 0x7; // we only have 8 locations 0-7
+    uint8_t base = location << 3;
+    if (!(_ret.cgram_used & (1 << location))) {
+        _ret.cgram_used |= 1 << location;
+        return _i2c_lcd_write_cgram(base, charmap, 8);
+    }
+    
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    bool written = false;
+    uint8_t start = 0;
+    while (start < 8 && status == I2C_LCD_OK) {
+        if (_ret.cgram[base + start] == (charmap[start] & 0x1F)) {
+            start++;
+            continue;
+        }
+        uint8_t end = start + 1;
+        while (end < 8 && (_ret.cgram[base + end] != (charmap[end] & 0x1F) || 
+            (end + 1 < 8 && _ret.cgram[base + end + 1] != (charmap[end + 1] & 0x1F)))) {
+            end++;
+        }
+        status = _i2c_lcd_write_cgram(base + start, &charmap[start], end - start);
+        written = true;
+        start = end;
+    }
+    if (!written) {
+        _stats.commands_elided++;
+    }
+    return status;
+}
+
+bool i2c_lcd_char_on_screen(uint8_t location) {
+    location &= 0x7;
+    for (uint8_t i = 0; i < LCD_DDRAM_SIZE; i++) {
+        // Character codes 0x08-0x0F show the same locations as 0x00-0x07
+        if (_ret.ddram[i] < 0x10 && (_ret.ddram[i] & 0x07) == location) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool i2c_lcd_char_matches(uint8_t location, const uint8_t *charmap) {
+    location &= 0x7;
+    if (!(_ret.cgram_used & (1 << location))) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        if (_ret.cgram[(location << 3) + i] != (charmap[i] & 0x1F)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+i2c_lcd_status_t i2c_lcd_left_to_right() {
+    _ret.entry_mode = LCD_ENTRY_INC;
+    return _i2c_lcd_update_entry_mode();
+}
+
+i2c_lcd_status_t i2c_lcd_right_to_left() {
+    _ret.entry_mode = LCD_ENTRY_DEC;
+    return _i2c_lcd_update_entry_mode();
+}
+
+i2c_lcd_status_t i2c_lcd_autoscroll_on() {
+    _ret.shift_mode = LCD_SHIFT_ON;
+    return _i2c_lcd_update_entry_mode();
+}
+
+i2c_lcd_status_t i2c_lcd_autoscroll_off() {
+    _ret.shift_mode = LCD_SHIFT_OFF;
+    return _i2c_lcd_update_entry_mode();
+}
+
+void i2c_lcd_batch_begin() {
+    _batch_depth++;
+}
+
+i2c_lcd_status_t i2c_lcd_batch_end() {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    if (_batch_depth == 0 || --_batch_depth > 0) {
+        return status;
+    }
+    if (_display_pending) {
+        _display_pending = false;
+        status = _i2c_lcd_update_display();
+    }
+    if (_backlight_pending && status == I2C_LCD_OK) {
+        _backlight_pending = false;
+        status = _i2c_lcd_update_backlight();
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Brings the controller back in step without the power up sequence. Three 
+ * 8bit function sets put it in 8bit mode whatever nibble it was waiting for: 
+ * if it was waiting for a low nibble the first one completes a (garbage) 
+ * instruction and the next two are a proper 8bit function set. From there 
+ * the normal 4bit switch is done and the state and screen are restored from 
+ * the RAM copy.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_resync() {
+    i2c_lcd_status_t status;
+    
+    _resyncing = true;
+    _resync_needed = true;
+    _stats.resyncs++;
+    _ac_valid = false;
+    _display_sent = 0xFF;
+    _entry_sent = 0xFF;
+    
+    // The garbage instruction may be a return home, wait for the slowest one
+    status = _i2c_send_and_wait_8bit(0x30, 2000);
+    if (status == I2C_LCD_OK) {
+        status = _i2c_send_and_wait_8bit(0x30, 200);
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_send_and_wait_8bit(0x30, 200);
+    }
+#if !LCD_8BIT_BUS
+    if (status == I2C_LCD_OK) {
+        status = _i2c_send_and_wait_8bit(0x20, 200);
+    }
+#endif
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_command(_i2c_lcd_function_cmd());
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_update_display();
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_update_entry_mode();
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_repaint(false);
+    }
+    _resyncing = false;
+    if (status == I2C_LCD_OK) {
+        _resync_needed = false;
+    }
+    return status;
+}
+
+void i2c_lcd_defer(uint8_t col, uint8_t row, const uint8_t *data, uint8_t length) {
+    if (!_fb_valid) {
+        for (uint8_t i = 0; i < LCD_DDRAM_SIZE; i++) {
+            _fb[i] = _ret.ddram[i];
+        }
+        _fb_valid = true;
+    }
+    uint8_t index = _i2c_lcd_ddram_index(_i2c_lcd_address(col, row));
+    for (uint8_t i = 0; i < length && index + i < LCD_DDRAM_SIZE; i++) {
+        _fb[index + i] = data[i];
+    }
+}
+
+void i2c_lcd_set_priority(uint8_t col, uint8_t row, uint8_t length, bool important) {
+    uint8_t index = _i2c_lcd_ddram_index(_i2c_lcd_address(col, row));
+    for (uint8_t i = index; i < index + length && i < LCD_DDRAM_SIZE; i++) {
+        if (important) {
+            _fb_priority[i / 8] |= 1 << (i % 8);
+        } else {
+            _fb_priority[i / 8] &= ~(1 << (i % 8));
+        }
+    }
+}
+
+uint8_t i2c_lcd_pending() {
+    uint8_t count = 0;
+    for (uint8_t i = 0; _fb_valid && i < LCD_DDRAM_SIZE; i++) {
+        if (_fb[i] != _ret.ddram[i]) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ ******************************************************************************
+ * Sends runs of pending cells (deferred cells that differ from the RAM copy 
+ * of the screen) until the next one would not fit in the budget. Priority 
+ * cells go first, then the others from where the last flush stopped so every 
+ * part of the screen gets its turn. The cost of a run is planned with the 
+ * driver's byte timing: one character time per cell plus one for the address 
+ * command when the address counter is elsewhere. A run that does not fit is 
+ * cut, the rest stays pending.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_flush_budget(uint32_t us) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    uint32_t char_us = _i2c_lcd_char_us();
+    uint8_t span = _i2c_lcd_span();
+    uint8_t line = NUM_LINES == LCD_TWO_LINES ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    bool reversed = _ret.entry_mode == LCD_ENTRY_DEC || _ret.shift_mode == LCD_SHIFT_ON;
+    bool out_of_time = false;
+    
+    if (!_fb_valid || i2c_lcd_pending() == 0) {
+        return status;
+    }
+    // The runs are sent directly, the controller has to be in step first (the 
+    // resync restores the entry mode, so before it is changed below)
+    if (_resync_needed) {
+        status = i2c_lcd_resync();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    }
+    // Runs are written left to right without shifting the display
+    if (reversed) {
+        // Entry mode is set and restored
+        if (us < 2 * char_us) {
+            return status;
+        }
+        us -= 2 * char_us;
+        _entry_sent = 0xFF;
+        status = _i2c_lcd_command(LCD_ENTRY_MODE_CMD | LCD_ENTRY_INC);
+    }
+    
+    for (uint8_t pass = 0; pass < 2 && !out_of_time && status == I2C_LCD_OK; pass++) {
+        uint8_t n = 0;
+        while (n < LCD_DDRAM_SIZE && status == I2C_LCD_OK) {
+            uint8_t index = (_fb_resume + n) % LCD_DDRAM_SIZE;
+            bool priority = (_fb_priority[index / 8] >> (index % 8)) & 0x01;
+            if (_fb[index] == _ret.ddram[index] || priority != (pass == 0) || 
+                index % line >= span) {
+                n++;
+                continue;
+            }
+            uint8_t len = 1;
+            while (index + len < LCD_DDRAM_SIZE && (index + len) % line != 0 && 
+                (index + len) % line < span && _fb[index + len] != _ret.ddram[index + len] && 
+                ((_fb_priority[(index + len) / 8] >> ((index + len) % 8)) & 0x01) == 
+                priority) {
+                len++;
+            }
+            uint8_t address = _i2c_lcd_ddram_address(index);
+            uint32_t setup = _ac_valid && !_ret.ac_cgram && _ret.ac == address ? 0 : char_us;
+            if (us < setup + char_us) {
+                out_of_time = true;
+                _fb_resume = index;
+                break;
+            }
+            if (setup + len * char_us > us) {
+                len = (us - setup) / char_us;
+            }
+            status = _i2c_lcd_flush_run(index, len);
+            us -= setup + len * char_us;
+            n += len;
+        }
+    }
+    if (!out_of_time) {
+        _fb_resume = 0;
+    }
+    if (reversed && status == I2C_LCD_OK) {
+        status = _i2c_lcd_update_entry_mode();
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Reads a chunk of DDRAM back and compares it to the RAM copy. The address 
+ * counter is read first: if it does not hold the address that was just set 
+ * the controller has lost its mode or nibble phase and is resynced (which 
+ * repaints everything). Reads follow the entry mode so the chunk is read 
+ * from its last cell when the address counter decrements. Mismatching cells 
+ * are rewritten one by one, without the display shift when autoscroll is on.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_scrub(uint32_t now_ms) {
+    if (_scrub_started && now_ms - _scrub_last_ms < I2C_LCD_SCRUB_PERIOD_MS) {
+        return I2C_LCD_OK;
+    }
+    _scrub_started = true;
+    _scrub_last_ms = now_ms;
+    // Nothing to compare with until an initialization has completed, nothing 
+    // to read back without an RW line
+    if (_ret.marker != I2C_LCD_MARKER || !LCD_CAN_READ) {
+        return I2C_LCD_OK;
+    }
+    if (_resync_needed) {
+        return i2c_lcd_resync();
+    }
+    
+    uint8_t lines = NUM_LINES == LCD_TWO_LINES ? 2 : 1;
+    uint8_t span = _i2c_lcd_span();
+    if (_scrub_index >= lines * span) {
+        _scrub_index = 0;
+    }
+    uint8_t line = _scrub_index / span;
+    uint8_t col = _scrub_index % span;
+    uint8_t count = span - col;
+    if (count > I2C_LCD_SCRUB_CELLS) {
+        count = I2C_LCD_SCRUB_CELLS;
+    }
+    uint8_t address = line * 0x40 + col;
+    bool increment = _ret.entry_mode == LCD_ENTRY_INC;
+    uint8_t first = increment ? address : address + count - 1;
+    uint8_t cells[I2C_LCD_SCRUB_CELLS];
+    uint8_t ac = 0xFF;
+    
+    _ac_valid = false;
+    i2c_lcd_status_t status = _i2c_lcd_command(LCD_SET_DDR_ADR_CMD | first);
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_read(INST_REGR, &ac, 1);
+    }
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    // Busy flag is bit 7, it must be clear by now
+    if (ac != first) {
+        _stats.scrub_mismatches++;
+        return i2c_lcd_resync();
+    }
+    status = _i2c_lcd_read(DATA_REGR, cells, count);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    _stats.scrub_checked += count;
+    
+    bool unshift = false;
+    for (uint8_t i = 0; i < count && status == I2C_LCD_OK; i++) {
+        uint8_t offset = increment ? i : count - 1 - i;
+        uint8_t index = _i2c_lcd_ddram_index(address + offset);
+        if (cells[i] == _ret.ddram[index]) {
+            continue;
+        }
+        _stats.scrub_mismatches++;
+        if (_ret.shift_mode == LCD_SHIFT_ON && !unshift) {
+            unshift = true;
+            _entry_sent = 0xFF;
+            status = _i2c_lcd_command(LCD_ENTRY_MODE_CMD | _ret.entry_mode);
+        }
+        if (status == I2C_LCD_OK) {
+            status = _i2c_lcd_command(LCD_SET_DDR_ADR_CMD | (address + offset));
+        }
+        if (status == I2C_LCD_OK) {
+            status = _i2c_lcd_send(&_ret.ddram[index], 1, MODE_4BIT, DATA_REGR);
+        }
+    }
+    if (unshift && status == I2C_LCD_OK) {
+        status = _i2c_lcd_update_entry_mode();
+    }
+    if (status == I2C_LCD_OK) {
+        _scrub_index += count;
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Same cell comparison as i2c_lcd_update, but the runs (and their address 
+ * commands) are encoded into _dma_frame as they are found and the frame goes 
+ * out as one transfer. A full frame is sent and waited for, the rest goes in 
+ * the next one. The RAM copy and the address counter are updated when the 
+ * frame is encoded, if the frame fails _i2c_lcd_dma_done schedules a resync 
+ * which repaints from the RAM copy. The MCP23017 strobe needs the 
+ * register pointer at port B for every character, it is written through 
+ * i2c_lcd_update.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_update_dma(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length) {
+#if LCD_8BIT_BUS
+    return i2c_lcd_update(col, row, data, length);
+#else
+    // The frame is encoded in place, the last one has to be off the bus
+    while (_dma_busy);
+    if (_resync_needed) {
+        i2c_lcd_status_t status = i2c_lcd_resync();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    }
+    uint8_t address = _i2c_lcd_address(col, row);
+    uint8_t span = NUM_LINES == LCD_TWO_LINES ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    uint8_t room = span - _i2c_lcd_ddram_index(address) % span;
+    if (length > room) {
+        length = room;
+    }
+    bool runs = _ret.entry_mode == LCD_ENTRY_INC && _ret.shift_mode == LCD_SHIFT_OFF;
+    uint16_t words = DMA_PREFIX_WORDS;
+    uint8_t start = 0;
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    _dma_frame[0] = MCP23008_GPIO;
+#endif
+    while (start < length) {
+        if (_ret.ddram[_i2c_lcd_ddram_index(address + start)] == data[start]) {
+            _stats.cells_elided++;
+            start++;
+            continue;
+        }
+        uint8_t end = start + 1;
+        while (runs && end < length && 
+            (_ret.ddram[_i2c_lcd_ddram_index(address + end)] != data[end] || 
+            (end + 1 < length && 
+            _ret.ddram[_i2c_lcd_ddram_index(address + end + 1)] != data[end + 1]))) {
+            end++;
+        }
+        // Cut the run to what is left of the frame
+        bool set_address = !_ac_valid || _ret.ac_cgram || _ret.ac != address + start;
+        uint8_t free = I2C_LCD_DMA_CHARS - (words - DMA_PREFIX_WORDS) / DMA_CHAR_WORDS;
+        if (free <= set_address) {
+            // Send the full frame and go on in the next one, this cell again
+            _i2c_lcd_dma_start(words);
+            while (_dma_busy);
+            words = DMA_PREFIX_WORDS;
+            if (_resync_needed) {
+                i2c_lcd_status_t status = i2c_lcd_resync();
+                if (status != I2C_LCD_OK) {
+                    return status;
+                }
+            }
+            continue;
+        }
+        if (end - start > free - set_address) {
+            end = start + free - set_address;
+        }
+        if (set_address) {
+            _ret.ac = address + start;
+            _ret.ac_cgram = false;
+            words = _i2c_lcd_encode(words, LCD_SET_DDR_ADR_CMD | _ret.ac, INST_REGR);
+            _stats.commands_sent++;
+            _ac_valid = true;
+        } else {
+            _stats.commands_elided++;
+        }
+        for (uint8_t i = start; i < end; i++) {
+            words = _i2c_lcd_encode(words, data[i], DATA_REGR);
+        }
+        _i2c_lcd_store_data(&data[start], end - start);
+        start = end;
+    }
+    if (words > DMA_PREFIX_WORDS) {
+        _i2c_lcd_dma_start(words);
+    }
+    return I2C_LCD_OK;
+#endif
+}
+
+bool i2c_lcd_dma_busy() {
+    return _dma_busy;
+}
+
+void i2c_lcd_dma_set_engine(i2c_lcd_dma_engine_t engine) {
+    while (_dma_busy);
+    _dma_engine = engine;
+}
+
+/**
+ ******************************************************************************
+ * Feeds the frame to the I2C FIFO word by word, the last word with a STOP, 
+ * then waits the time the frame takes on the wire (I2C_LCD_DMA_WORD_US per 
+ * word) before calling [cb], so the timing seen by the application is the 
+ * one of a DMA transfer. An abort ends the frame early, it is only known for 
+ * sure once the FIFO is empty and the controller idle.
+ ******************************************************************************
+ */
+void i2c_lcd_dma_standin(uint16_t *data, uint16_t len, i2c_complete_cb_t cb, 
+    void *cb_data, uint32_t flags) {
+    uint16_t sent = 0;
+    bool aborted = false;
+    while (sent < len && !aborted) {
+        uint16_t word = data[sent];
+        if (sent + 1 == len && (flags & I2C_F_ADD_STOP)) {
+            word |= I2C_STOP;
+        }
+        while (!i2c_is_tx_fifo_not_full());
+        i2c_write_byte(word);
+        sent++;
+        // An abort flushes the FIFO, no point in feeding it
+        aborted = i2c_get_abort_source() != I2C_ABORT_NONE;
+    }
+    systick_wait(sent * I2C_LCD_DMA_WORD_US);
+    while (!i2c_is_tx_fifo_empty());
+    while (i2c_is_master_busy());
+    // Every queued byte has been acknowledged (or not) by now
+    if (i2c_get_abort_source() != I2C_ABORT_NONE) {
+        aborted = true;
+        i2c_reset_int_tx_abort();
+    }
+    if (cb != NULL) {
+        cb(cb_data, sent, !aborted);
+    }
+}
+
+i2c_lcd_status_t i2c_lcd_group_init(i2c_lcd_group_t *group) {
+#if LCD_8BIT_BUS
+    return I2C_LCD_ERR_ABORT;
+#else
+    // Same sequence as _i2c_lcd_power_up, without the backlight only step
+    static const uint8_t wake[] = { 0x30, 0x30, 0x30, 0x20 };
+    static const uint16_t wake_us[] = { 4500, 4500, 200, 200 };
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    uint16_t words;
+    
+    group->glyph_mask = 0;
+    _i2c_lcd_wait(50000);
+    
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    // Register writes, see _i2c_lcd_expander_setup
+    words = _i2c_lcd_group_frame();
+    _dma_frame[0] = MCP23008_IOCON;
+    _dma_frame[words++] = MCP_IOCON_SEQOP;
+    status = _i2c_lcd_group_send(group, words);
+    words = _i2c_lcd_group_frame();
+    _dma_frame[0] = MCP23008_IODIR;
+    _dma_frame[words++] = 0x00;
+    if (_i2c_lcd_group_send(group, words) != I2C_LCD_OK) {
+        status = I2C_LCD_ERR_ABORT;
+    }
+#endif
+    
+    // 8bit function sets, one strobe each
+    for (uint8_t i = 0; i < sizeof(wake); i++) {
+        uint8_t cmd[STROBE_BYTES];
+        i2c_lcd_get_8bit_cmd(wake[i], cmd, INST_REGR);
+        words = _i2c_lcd_group_frame();
+        for (uint8_t j = 0; j < STROBE_BYTES; j++) {
+            _dma_frame[words++] = (cmd[j] & ~I2C_LCD_PIN_BL) | 
+                BACKLIGHT_PIN(group->backlight);
+        }
+        if (_i2c_lcd_group_send(group, words) != I2C_LCD_OK) {
+            status = I2C_LCD_ERR_ABORT;
+        }
+        _i2c_lcd_wait(wake_us[i]);
+    }
+    
+    // 4bit from here, the idle words cover the execution times
+    words = _i2c_lcd_group_frame();
+    words = _i2c_lcd_group_encode(group, words, _i2c_lcd_function_cmd(), INST_REGR);
+    words = _i2c_lcd_group_encode(group, words, 0x0C, INST_REGR); // display on
+    words = _i2c_lcd_group_encode(group, words, LCD_ENTRY_MODE_CMD | LCD_ENTRY_INC, 
+        INST_REGR);
+    words = _i2c_lcd_group_encode(group, words, LCD_CLEAR_CMD, INST_REGR);
+    if (_i2c_lcd_group_send(group, words) != I2C_LCD_OK) {
+        status = I2C_LCD_ERR_ABORT;
+    }
+    // Clear command takes longer than a normal command
+    _i2c_lcd_wait(2000);
+    return status;
+#endif
+}
+
+i2c_lcd_status_t i2c_lcd_group_print(i2c_lcd_group_t *group, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length) {
+#if LCD_8BIT_BUS
+    return I2C_LCD_ERR_ABORT;
+#else
+    uint8_t address = _i2c_lcd_address(col, row);
+    uint8_t span = NUM_LINES == LCD_TWO_LINES ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    uint8_t room = span - _i2c_lcd_ddram_index(address) % span;
+    if (length > room) {
+        length = room;
+    }
+    
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    uint8_t start = 0;
+    while (start < length && status == I2C_LCD_OK) {
+        // Each frame starts with its address, the rest of it is text
+        uint8_t end = length - start < I2C_LCD_DMA_CHARS - 1 ? length : 
+            start + I2C_LCD_DMA_CHARS - 1;
+        uint16_t words = _i2c_lcd_group_frame();
+        words = _i2c_lcd_group_encode(group, words, 
+            LCD_SET_DDR_ADR_CMD | (address + start), INST_REGR);
+        for (uint8_t i = start; i < end; i++) {
+            words = _i2c_lcd_group_encode(group, words, data[i], DATA_REGR);
+        }
+        status = _i2c_lcd_group_send(group, words);
+        start = end;
+    }
+    return status;
+#endif
+}
+
+i2c_lcd_status_t i2c_lcd_group_create_char(i2c_lcd_group_t *group, uint8_t location, 
+    const uint8_t *charmap) {
+#if LCD_8BIT_BUS
+    return I2C_LCD_ERR_ABORT;
+#else
+    location &= 0x7; // we only have 8 locations 0-7
+    if (group->glyph_mask & (1 << location)) {
+        uint8_t i = 0;
+        while (i < 8 && group->glyphs[location][i] == (charmap[i] & 0x1F)) {
+            i++;
+        }
+        if (i == 8) {
+            return I2C_LCD_OK;
+        }
+    }
+    
+    uint16_t words = _i2c_lcd_group_frame();
+    words = _i2c_lcd_group_encode(group, words, LCD_SET_CGR_ADR_CMD | (location << 3), 
+        INST_REGR);
+    for (uint8_t i = 0; i < 8; i++) {
+        group->glyphs[location][i] = charmap[i] & 0x1F;
+        words = _i2c_lcd_group_encode(group, words, group->glyphs[location][i], 
+            DATA_REGR);
+    }
+    i2c_lcd_status_t status = _i2c_lcd_group_send(group, words);
+    // A display that missed it has to get it again next time
+    if (status == I2C_LCD_OK) {
+        group->glyph_mask |= 1 << location;
+    } else {
+        group->glyph_mask &= ~(1 << location);
+    }
+    return status;
+#endif
+}
+
+void i2c_lcd_set_yield(i2c_lcd_yield_t yield, uint32_t min_us) {
+    _yield = yield;
+    _yield_min_us = min_us;
+}
+
+i2c_lcd_bus_client_t *i2c_lcd_get_bus_client() {
+    return &_bus_client;
+}
+
+void i2c_lcd_get_stats(i2c_lcd_stats_t *stats) {
+    *stats = _stats;
+}
+
+void i2c_lcd_reset_stats() {
+    i2c_lcd_stats_t zero = { 0 };
+    _stats = zero;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Internal lower level I2C code                                             */ 
+/*---------------------------------------------------------------------------*/
+
+static uint8_t _i2c_lcd_display_cmd () {
+    return LCD_DISPLAY_CMD | _ret.display | _ret.cursor | _ret.blink;
+}
+
+static uint8_t _i2c_lcd_entry_mode_cmd () {
+    return LCD_ENTRY_MODE_CMD | _ret.entry_mode | _ret.shift_mode;
+}
+
+static uint8_t _i2c_lcd_function_cmd () {
+    // 0x10 keeps the controller in 8bit mode
+    return LCD_FUNCTION_CMD | (LCD_8BIT_BUS ? 0x10 : 0x00) | NUM_LINES | 
+        I2C_LCD_FONT_MODE;
+}
+
+/**
+ ******************************************************************************
+ * Private function that sends the display control command unless the 
+ * controller already has it. Inside a batch the command is only marked as 
+ * pending and goes out (once) when the batch ends.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_update_display() {
+    uint8_t cmd = _i2c_lcd_display_cmd();
+    if (_batch_depth > 0) {
+        if (_display_pending) {
+            _stats.commands_merged++;
+        }
+        _display_pending = true;
+        return I2C_LCD_OK;
+    }
+    if (cmd == _display_sent) {
+        _stats.commands_elided++;
+        return I2C_LCD_OK;
+    }
+    i2c_lcd_status_t status = _i2c_lcd_command(cmd);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    // The execution time is in the slack _i2c_send waits, like every command
+    _display_sent = cmd;
+    return I2C_LCD_OK;
+}
+
+/**
+ ******************************************************************************
+ * Private function that puts the backlight bit on the expander. The backlight 
+ * is bit 3 of the PCF8574 port and is carried by every byte, so a single port 
+ * write with the enable line low is enough; the HD44780 only samples the data 
+ * lines on the falling edge of enable, so its nibble state is not disturbed. 
+ * Inside a batch the write is held back and is dropped if any other traffic 
+ * has already carried the new bit when the batch ends.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_update_backlight() {
+    if (_batch_depth > 0) {
+        if (_backlight_pending) {
+            _stats.commands_merged++;
+        }
+        _backlight_pending = true;
+        return I2C_LCD_OK;
+    }
+    if (_backlight_out == _backlight_sent) {
+        _stats.commands_elided++;
+        return I2C_LCD_OK;
+    }
+    i2c_lcd_status_t status = _i2c_lcd_write_port(
+        (_port & ~(I2C_LCD_PIN_BL | LCD_ENABLE)) | _backlight_out);
+    if (status == I2C_LCD_OK) {
+        _backlight_sent = _backlight_out;
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that sends the entry mode command unless the controller 
+ * already has it.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_update_entry_mode() {
+    uint8_t cmd = _i2c_lcd_entry_mode_cmd();
+    if (cmd == _entry_sent) {
+        _stats.commands_elided++;
+        return I2C_LCD_OK;
+    }
+    i2c_lcd_status_t status = _i2c_lcd_command(cmd);
+    if (status == I2C_LCD_OK) {
+        _entry_sent = cmd;
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that follows the address counter after a data write. In 
+ * two line mode the lines are 0x00-0x27 and 0x40-0x67 and the counter wraps 
+ * from the end of one line to the start of the other. In one line mode it 
+ * runs from 0x00 to 0x4F. CGRAM addresses run from 0x00 to 0x3F.
+ ******************************************************************************
+ */
+static void _i2c_lcd_advance_ac() {
+    bool increment = (_ret.entry_mode & LCD_ENTRY_INC) != 0;
+    if (_ret.ac_cgram) {
+        _ret.ac = (increment ? _ret.ac + 1 : _ret.ac - 1) & (LCD_CGRAM_SIZE - 1);
+        return;
+    }
+    if (increment) {
+        _ret.ac++;
+        if (NUM_LINES == LCD_TWO_LINES) {
+            if (_ret.ac == 0x28) {
+                _ret.ac = 0x40;
+            } else if (_ret.ac == 0x68) {
+                _ret.ac = 0x00;
+            }
+        } else if (_ret.ac == 0x50) {
+            _ret.ac = 0x00;
+        }
+    } else {
+        if (NUM_LINES == LCD_TWO_LINES) {
+            if (_ret.ac == 0x00) {
+                _ret.ac = 0x67;
+            } else if (_ret.ac == 0x40) {
+                _ret.ac = 0x27;
+            } else {
+                _ret.ac--;
+            }
+        } else {
+            _ret.ac = _ret.ac == 0x00 ? 0x4F : _ret.ac - 1;
+        }
+    }
+}
+
+/**
+ ******************************************************************************
+ * Private function that maps a DDRAM address to its place in the RAM copy. 
+ * In two line mode the second line (0x40-0x67) follows the first (0x00-0x27).
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_ddram_index(uint8_t address) {
+    if (NUM_LINES == LCD_TWO_LINES && address >= 0x40) {
+        return (address - 0x40 + LCD_LINE_SIZE) % LCD_DDRAM_SIZE;
+    }
+    return address % LCD_DDRAM_SIZE;
+}
+
+/**
+ ******************************************************************************
+ * Private function that maps a place in the RAM copy back to its DDRAM 
+ * address, the reverse of _i2c_lcd_ddram_index.
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_ddram_address(uint8_t index) {
+    if (NUM_LINES == LCD_TWO_LINES && index >= LCD_LINE_SIZE) {
+        return index - LCD_LINE_SIZE + 0x40;
+    }
+    return index;
+}
+
+/**
+ ******************************************************************************
+ * Private function that writes deferred cells [index] to [index + len - 1] 
+ * (on one line) with the address counter incrementing and no display shift.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_flush_run(uint8_t index, uint8_t len) {
+    uint8_t address = _i2c_lcd_ddram_address(index);
+    i2c_lcd_status_t status = _i2c_lcd_goto(address);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        _ret.ddram[index + i] = _fb[index + i];
+    }
+    status = _i2c_lcd_send(&_fb[index], len, MODE_4BIT, DATA_REGR);
+    // The counter wraps to the other line at the end of a line
+    uint8_t line = NUM_LINES == LCD_TWO_LINES ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    _ret.ac = address + len;
+    _ac_valid = status == I2C_LCD_OK && index % line + len < line;
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that turns a column and row into a DDRAM address. Rows 
+ * past the last one are clamped to it.
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_address(uint8_t col, uint8_t row) {
+    static const uint8_t row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
+    if (row >= NUM_ROWS) {
+        row = NUM_ROWS - 1;    // we count rows starting w/0
+    }
+    return (col + row_offsets[row]) & 0x7F;
+}
+
+/**
+ ******************************************************************************
+ * Private function that moves the address counter to a DDRAM address unless 
+ * it already points there.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_goto(uint8_t address) {
+    if (_ac_valid && !_ret.ac_cgram && _ret.ac == address) {
+        _stats.commands_elided++;
+        return I2C_LCD_OK;
+    }
+    _ret.ac = address;
+    _ret.ac_cgram = false;
+    return _i2c_lcd_restore_ac();
+}
+
+/**
+ ******************************************************************************
+ * Private function that writes glyph rows to CGRAM. The address command is 
+ * dropped when the address counter already points there (e.g. when glyphs 
+ * are created in consecutive locations). The address counter is left in 
+ * CGRAM, the next print needs a set_cursor.
+ * 
+ * @param[in] address  CGRAM address, location * 8 + row
+ * @param[in] data     glyph rows
+ * @param[in] len      number of rows
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_write_cgram(uint8_t address, const uint8_t *data, 
+    uint8_t len) {
+    if (!_ac_valid || !_ret.ac_cgram || _ret.ac != address) {
+        _ret.ac = address;
+        _ret.ac_cgram = true;
+        i2c_lcd_status_t status = _i2c_lcd_restore_ac();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    } else {
+        _stats.commands_elided++;
+    }
+    return _i2c_lcd_write_data(data, len);
+}
+
+/**
+ ******************************************************************************
+ * Private function that sets the controller address counter to _ret.ac 
+ * (DDRAM or CGRAM).
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_restore_ac() {
+    uint8_t cmd = _ret.ac_cgram ? LCD_SET_CGR_ADR_CMD | (_ret.ac & 0x3F) : 
+        LCD_SET_DDR_ADR_CMD | (_ret.ac & 0x7F);
+    i2c_lcd_status_t status = _i2c_lcd_command(cmd);
+    _ac_valid = status == I2C_LCD_OK;
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that writes to the data register and keeps the RAM copy 
+ * and the address counter up to date. The RAM copy always holds what was 
+ * asked for, even when the transfer fails, so a resync can put it on screen.
+ * 
+ * @param[in] data  data pointer (typically a char array)
+ * @param[in] len   length of [data] to write
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_write_data(const uint8_t *data, uint16_t len) {
+    if (_resync_needed && !_resyncing) {
+        i2c_lcd_status_t status = i2c_lcd_resync();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    }
+    // Put the address counter back where the RAM copy expects it
+    if (!_ac_valid) {
+        i2c_lcd_status_t status = _i2c_lcd_restore_ac();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    }
+    _i2c_lcd_store_data(data, len);
+    i2c_lcd_status_t status = _i2c_lcd_send(data, len, MODE_4BIT, DATA_REGR);
+    if (status != I2C_LCD_OK) {
+        _ac_valid = false;
+    }
+    return status;
+}
 
-/*-------------------------------------------------------------------------- */
-/* LCD API Functions                                                         */ 
-/*---------------------------------------------------------------------------*/
+/**
+ ******************************************************************************
+ * Private function that puts data written to the data register in the RAM 
+ * copy and moves the address counter (and the display shift) on the way the 
+ * controller will.
+ ******************************************************************************
+ */
+static void _i2c_lcd_store_data(const uint8_t *data, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        if (_ret.ac_cgram) {
+            _ret.cgram[_ret.ac] = data[i] & 0x1F;
+        } else {
+            uint8_t index = _i2c_lcd_ddram_index(_ret.ac);
+            _ret.ddram[index] = data[i];
+            if (_fb_valid) {
+                _fb[index] = data[i];
+            }
+            // With autoscroll every character written shifts the display
+            if (_ret.shift_mode == LCD_SHIFT_ON) {
+                _ret.display_shift = (_ret.display_shift + 
+                    (_ret.entry_mode == LCD_ENTRY_INC ? -1 : 1)) % 40;
+            }
+        }
+        _i2c_lcd_advance_ac();
+    }
+}
 
 /**
  ******************************************************************************
  * This is the software initialization procedure as described in the 
- * HD44780U Instruction manual, pg. 46
+ * HD44780U Instruction manual, pg. 46 (pg. 45 for an 8bit bus). It leaves 
+ * the controller cleared, in 4bit mode (8bit on the MCP23017) with the 
+ * display on, it does not touch the retained state.
  ******************************************************************************
  */
-void i2c_lcd_init() {
+static i2c_lcd_status_t _i2c_lcd_power_up() {
+    i2c_lcd_status_t status;
+    
     // Wait 50ms for power up (systick is in microseconds 50000us = 50ms)
-    systick_wait(50000);
+    _i2c_lcd_wait(50000);
     
     // Set the address of the LCD
     _i2c_lcd_set_address();
     
+    // The MCP expanders power up with every pin an input
+    status = _i2c_lcd_expander_setup();
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    
+    // Nothing is known about the controller until the sequence below completes
+    _ac_valid = false;
+    _display_sent = 0xFF;
+    _entry_sent = 0xFF;
+    _backlight_sent = 0xFF;
+    _resync_needed = false;
+    
     // Send command to turn off the backlight (this step is ommitted in the manual)
-    uint8_t data[1] = {_backlight};
-    i2c_abort_t abort_code;
-    i2c_master_transmit_buffer_sync(data, 1, &abort_code, I2C_F_ADD_STOP);
-    systick_wait(200);
+    status = _i2c_lcd_write_port(_backlight_out);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    _backlight_sent = _backlight_out;
+    _i2c_lcd_wait(200);
     
     // 8bit mode function set called 3x
-    _i2c_send_and_wait_8bit(0x30, 4500); // send and wait 4.5ms
-    _i2c_send_and_wait_8bit(0x30, 4500); // send and wait 4.5ms
-    _i2c_send_and_wait_8bit(0x30, 200);  // send and wait 200us
+    status = _i2c_send_and_wait_8bit(0x30, 4500); // send and wait 4.5ms
+    if (status == I2C_LCD_OK) {
+        status = _i2c_send_and_wait_8bit(0x30, 4500); // send and wait 4.5ms
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_send_and_wait_8bit(0x30, 200);  // send and wait 200us
+    }
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
     
+#if !LCD_8BIT_BUS
     // Send the command to switch to 4bit mode (in 8bit mode)
     uint8_t mode_4bit[1] = {0x20};
-    _i2c_lcd_send(mode_4bit, 1, MODE_8BIT, INST_REGR);
+    status = _i2c_lcd_send(mode_4bit, 1, MODE_8BIT, INST_REGR);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+#endif
     
     // Now we are in 4bit mode. Not we are not checking the BF flag so wait times
     // are hard coded according to the datasheet
     uint8_t data_4bit[2] = { 
-        0x28, // function set - 2 lines and 5x8 char set
+        _i2c_lcd_function_cmd(), // function set - 2 lines and 5x8 char set
         0x0C, // display off
      };
-    _i2c_lcd_send(data_4bit, 2, MODE_4BIT, INST_REGR);
+    status = _i2c_lcd_send(data_4bit, 2, MODE_4BIT, INST_REGR);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    _display_sent = 0x0C;
     
     // Clear command takes longer than a normal command
-    i2c_lcd_clear();
+    status = _i2c_lcd_command(LCD_CLEAR_CMD);
+    _i2c_lcd_wait(2000);
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that writes the RAM copy back to the controller: the CGRAM 
+ * locations that have been used and the visible part of each DDRAM line (the 
+ * whole line when the display is shifted). The display shift and the address 
+ * counter are restored last.
+ * 
+ * @param[in] cleared  the controller was just cleared, spaces are skipped and 
+ *                     only runs of other characters are written; otherwise 
+ *                     the shift is reset with a return home as well
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_repaint(bool cleared) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
     
-    // Entry mode set is the final instruction
-    _i2c_lcd_command(_i2c_lcd_entry_mode_cmd()); // entry mode set
+    for (uint8_t location = 0; location < 8 && status == I2C_LCD_OK; location++) {
+        if (_ret.cgram_used & (1 << location)) {
+            status = _i2c_lcd_command(LCD_SET_CGR_ADR_CMD | (location << 3));
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_send(&_ret.cgram[location << 3], 8, 
+                    MODE_4BIT, DATA_REGR);
+            }
+        }
+    }
     
-    // This is not in the instructions but I figure its a nice thing to do.
-    i2c_lcd_backlight_on();
+    uint8_t lines = NUM_LINES == LCD_TWO_LINES ? 2 : 1;
+    uint8_t span = _i2c_lcd_span();
+    // Entry mode is restored at this point, write the lines in increasing order
+    bool reversed = _ret.entry_mode == LCD_ENTRY_DEC || 
+        _ret.shift_mode == LCD_SHIFT_ON;
+    if (reversed && status == I2C_LCD_OK) {
+        status = _i2c_lcd_command(LCD_ENTRY_MODE_CMD | LCD_ENTRY_INC);
+        _entry_sent = 0xFF;
+    }
+    for (uint8_t line = 0; line < lines && status == I2C_LCD_OK; line++) {
+        const uint8_t *cells = &_ret.ddram[line * LCD_LINE_SIZE];
+        uint8_t start = 0;
+        while (start < span && status == I2C_LCD_OK) {
+            if (cleared && cells[start] == ' ') {
+                start++;
+                continue;
+            }
+            // A run goes on over single spaces, a new address costs as much
+            uint8_t end = start + 1;
+            while (end < span && (!cleared || cells[end] != ' ' || 
+                (end + 1 < span && cells[end + 1] != ' '))) {
+                end++;
+            }
+            status = _i2c_lcd_command(LCD_SET_DDR_ADR_CMD | (line * 0x40 + start));
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_send(&cells[start], end - start, MODE_4BIT, 
+                    DATA_REGR);
+            }
+            start = end;
+        }
+    }
+    if (reversed && status == I2C_LCD_OK) {
+        status = _i2c_lcd_update_entry_mode();
+    }
+    
+    // Return home clears the shift, then shift back to where we were. Unless 
+    // the controller was just cleared its shift is not known (the garbage 
+    // instruction of a resync may have been a shift), so it is always reset.
+    if ((!cleared || _ret.display_shift != 0) && status == I2C_LCD_OK) {
+        status = _i2c_lcd_command(LCD_HOME_CMD);
+        _i2c_lcd_wait(2000);
+        for (int8_t i = 0; i < _ret.display_shift && status == I2C_LCD_OK; i++) {
+            status = _i2c_lcd_command(0x1C);
+        }
+        for (int8_t i = 0; i > _ret.display_shift && status == I2C_LCD_OK; i--) {
+            status = _i2c_lcd_command(0x18);
+        }
+    }
+    
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_restore_ac();
+    }
+    return status;
 }
 
-void i2c_lcd_print(uint8_t *data, uint8_t length) {
-    _i2c_lcd_send(data, length, MODE_4BIT, DATA_REGR);
+/**
+ ******************************************************************************
+ * Private function that returns how many cells of each DDRAM line can be on 
+ * screen: the visible part, or the whole line when the display is shifted.
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_span() {
+    uint8_t lines = NUM_LINES == LCD_TWO_LINES ? 2 : 1;
+    uint8_t span = lines == 2 ? LCD_LINE_SIZE : LCD_DDRAM_SIZE;
+    uint8_t visible = NUM_COLMS * ((NUM_ROWS + lines - 1) / lines);
+    if (_ret.display_shift == 0 && visible < span) {
+        span = visible;
+    }
+    return span;
 }
 
-void i2c_lcd_backlight_off() {
-    _backlight = LCD_BACKLIGHT_OFF;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
+/**
+ ******************************************************************************
+ * Private function that holds the timing of the expander bytes: the time 
+ * byte [index] of a 3 byte (enable low, high, low) nibble sequence (or of 
+ * the 5 byte MCP23017 strobe) takes, 
+ * on the wire and in the wait after it. Everything that plans bus time uses 
+ * it.
+ * 
+ * @param[in] index  position of the byte in the transfer
+ ******************************************************************************
+ */
+static uint32_t _i2c_lcd_byte_us(uint16_t index) {
+    return WIRE_BYTE_US + _i2c_lcd_slack_us(index);
 }
 
-void i2c_lcd_backlight_on() {
-    _backlight = LCD_BACKLIGHT_ON;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
+/**
+ ******************************************************************************
+ * Private function that returns the wait needed after byte [index] on top of 
+ * the time the bus already takes. Every byte is its own transfer so the 
+ * enable pulse (450ns) and the cycle time (1us) are always covered. After 
+ * the enable falls at the end of a nibble the next falling edge comes three 
+ * transfers later (five bytes on the MCP23017) and must not come before the 
+ * controller has executed the character (I2C_LCD_EXEC_US).
+ * 
+ * @param[in] index  position of the byte in the transfer
+ ******************************************************************************
+ */
+static uint32_t _i2c_lcd_slack_us(uint16_t index) {
+    if ((index + 1) % STROBE_BYTES == 0 && 
+        I2C_LCD_EXEC_US > STROBE_BYTES * WIRE_BYTE_US) {
+        return I2C_LCD_EXEC_US - STROBE_BYTES * WIRE_BYTE_US;
+    }
+    return 0;
 }
 
-void i2c_lcd_clear() {
-    _i2c_lcd_command(0x01);
-    systick_wait(2000);
+/**
+ ******************************************************************************
+ * Private function that returns the bus time of one character or 
+ * instruction (6 expander bytes, 5 on the MCP23017).
+ ******************************************************************************
+ */
+static uint32_t _i2c_lcd_char_us() {
+    uint32_t us = 0;
+    for (uint8_t i = 0; i < CHAR_BYTES; i++) {
+        us += _i2c_lcd_byte_us(i);
+    }
+    return us;
 }
 
-void i2c_lcd_clear_line(uint8_t length) {
-    // 40 space buffer because 40 is the max length of any display we'll use
-    uint8_t buffer[] = "                                        ";
-    _i2c_lcd_send(buffer, length, MODE_4BIT, DATA_REGR);
+/**
+ ******************************************************************************
+ * Private function for every wait the driver does between two transfers. A 
+ * long wait goes to the yield callback first, only the time it did not use 
+ * is spun.
+ * 
+ * @param[in] us  microseconds to wait
+ ******************************************************************************
+ */
+static void _i2c_lcd_wait(uint32_t us) {
+    if (_yield != NULL && us > 0 && us >= _yield_min_us) {
+        uint32_t used = _yield(us);
+        if (used > us) {
+            used = us;
+        }
+        _stats.wait_us += used;
+        _stats.yields++;
+        _stats.yield_us += used;
+        us -= used;
+    }
+    _i2c_lcd_spin(us);
 }
 
-void i2c_lcd_home() {
-    _i2c_lcd_command(0x02);
-    systick_wait(2000);
+/**
+ ******************************************************************************
+ * Private function that busy waits, used inside a transfer where the yield 
+ * callback could leave another target selected. Keeps count of the time 
+ * spent waiting.
+ * 
+ * @param[in] us  microseconds to wait
+ ******************************************************************************
+ */
+static void _i2c_lcd_spin(uint32_t us) {
+    _stats.wait_us += us;
+    if (us > 0) {
+        systick_wait(us);
+    }
 }
 
-void i2c_lcd_set_cursor(uint8_t col, uint8_t row) {
-    int row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
-	if ( row > NUM_LINES ) {
-		row = NUM_LINES-1;    // we count rows starting w/0
-	}
-	_i2c_lcd_command(LCD_SET_DDR_ADR_CMD | (col + row_offsets[row]));
+/**
+ ******************************************************************************
+ * Private function that makes the LCD the target before a transfer. Waits 
+ * for a DMA frame still on the bus and lets the jobs of higher priority 
+ * clients go first (see i2c_lcd_bus_select).
+ ******************************************************************************
+ */
+static void _i2c_lcd_set_address()
+{
+    i2c_lcd_bus_select(&_bus_client);
 }
 
-void i2c_lcd_shift_right() {
-    _i2c_lcd_command(0x1C);
-};
+/**
+ ******************************************************************************
+ * Private function that writes a single byte to the expander port without 
+ * any HD44780 timing. With the MCP expanders the byte goes to the GPIO 
+ * register (port B, the control lines, on the MCP23017).
+ * 
+ * @param[in] port  value for P0-P7 of the expander
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_write_port(uint8_t port) {
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    i2c_lcd_status_t status = _i2c_lcd_write_reg(MCP23008_GPIO, port);
+#elif I2C_LCD_BACKEND == I2C_LCD_MCP23017
+    i2c_lcd_status_t status = _i2c_lcd_write_reg(MCP23017_GPIOB, port);
+#else
+    i2c_lcd_status_t status = _i2c_lcd_write_reg(0, port);
+#endif
+    if (status == I2C_LCD_OK) {
+        _port = port;
+    }
+    return status;
+}
 
-void i2c_lcd_shift_left(){
-    _i2c_lcd_command(0x18);
-};
+/**
+ ******************************************************************************
+ * Private function that writes an expander register in one transfer. The 
+ * PCF8574 has no registers, [reg] is ignored and [value] is the port.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_write_reg(uint8_t reg, uint8_t value) {
+    _i2c_lcd_set_address();
+#if I2C_LCD_BACKEND == I2C_LCD_PCF8574
+    uint8_t data[1] = { value };
+    (void)reg;
+#else
+    uint8_t data[2] = { reg, value };
+#endif
+    i2c_abort_t abort_code = I2C_ABORT_NONE;
+    for (uint8_t attempt = 0; attempt <= I2C_LCD_RETRIES; attempt++) {
+        if (attempt > 0) {
+            _stats.retries++;
+        }
+        i2c_master_transmit_buffer_sync(data, sizeof(data), &abort_code, I2C_F_ADD_STOP);
+        if (abort_code == I2C_ABORT_NONE) {
+            _stats.bus_bytes++;
+            return I2C_LCD_OK;
+        }
+        _stats.aborts++;
+    }
+    return I2C_LCD_ERR_ABORT;
+}
 
-void i2c_lcd_display_on() {
-    _display = LCD_DISPLAY_ON;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_display_off() {
-    _display = 0x00;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_blink_on() {
-    _blink = LCD_BLINK_ON;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_blink_off() {
-    _blink = 0x00;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_cursor_on() {
-    _cursor = LCD_CURSOR_ON;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_cursor_off() {
-    _cursor = 0x00;
-    _i2c_lcd_command(_i2c_lcd_display_cmd());
-    systick_wait(200);
-};
-void i2c_lcd_create_char(uint8_t location, uint8_t *charmap) {
-    location &= 0x7; // we only have 8 locations 0-7
-    // This command makes it so we write to the character ram
-	_i2c_lcd_command(LCD_SET_CGR_ADR_CMD | (location << 3));
-	for (int i=0; i<8; i++) {
-		_i2c_lcd_send(&charmap[i], 1, MODE_4BIT, DATA_REGR);
-	}
+/**
+ ******************************************************************************
+ * Private function that reads one byte from the expander port: P0-P7 of the 
+ * PCF8574, GPIO of the MCP23008 and port A (the data lines) of the MCP23017.
+ * 
+ * @param[out] port  value of the port
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_read_port(uint8_t *port) {
+    i2c_abort_t abort_code = I2C_ABORT_NONE;
+#if I2C_LCD_BACKEND != I2C_LCD_PCF8574
+    uint8_t reg[1] = { LCD_8BIT_BUS ? MCP23017_GPIOA : MCP23008_GPIO };
+    i2c_master_transmit_buffer_sync(reg, 1, &abort_code, I2C_F_NONE);
+    if (abort_code != I2C_ABORT_NONE) {
+        _stats.aborts++;
+        return I2C_LCD_ERR_ABORT;
+    }
+#endif
+    i2c_master_receive_buffer_sync(port, 1, &abort_code, I2C_F_ADD_STOP);
+    if (abort_code != I2C_ABORT_NONE) {
+        _stats.aborts++;
+        return I2C_LCD_ERR_ABORT;
+    }
+    _stats.bus_bytes++;
+    return I2C_LCD_OK;
 }
 
-/*-------------------------------------------------------------------------- */
-/* Internal lower level I2C code                                             */ 
-/*---------------------------------------------------------------------------*/
+/**
+ ******************************************************************************
+ * Private function that gets an MCP expander ready after it was powered: 
+ * the register pointer is set not to increment (on the MCP23017 it toggles 
+ * between port A and B, which the character strobe relies on) and every pin 
+ * is made an output. Nothing to do for the PCF8574.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_expander_setup() {
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    i2c_lcd_status_t status = _i2c_lcd_write_reg(MCP23008_IOCON, MCP_IOCON_SEQOP);
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_write_reg(MCP23008_IODIR, 0x00);
+    }
+    return status;
+#elif I2C_LCD_BACKEND == I2C_LCD_MCP23017
+    i2c_lcd_status_t status = _i2c_lcd_write_reg(MCP23017_IOCON, MCP_IOCON_SEQOP);
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_write_reg(MCP23017_IODIRA, 0x00);
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_write_reg(MCP23017_IODIRA + 1, 0x00);
+    }
+    return status;
+#else
+    return I2C_LCD_OK;
+#endif
+}
 
-static uint8_t _i2c_lcd_display_cmd () {
-    return LCD_DISPLAY_CMD | _display | _cursor | _blink;
+/**
+ ******************************************************************************
+ * Private function that turns the data pins around for a read. The PCF8574 
+ * pins are quasi-bidirectional, they are written high and the LCD pulls them 
+ * low, which the caller does. The MCP pins have to be made inputs.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_data_direction(bool input) {
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    return _i2c_lcd_write_reg(MCP23008_IODIR, input ? DATA_PINS : 0x00);
+#elif I2C_LCD_BACKEND == I2C_LCD_MCP23017
+    return _i2c_lcd_write_reg(MCP23017_IODIRA, input ? 0xFF : 0x00);
+#else
+    (void)input;
+    return I2C_LCD_OK;
+#endif
 }
 
-static uint8_t _i2c_lcd_entry_mode_cmd () {
-    return LCD_ENTRY_MODE_CMD | _entry_mode | _shift_mode;
+/**
+ ******************************************************************************
+ * Private function that reads from the controller. The data lines are 
+ * turned around (see _i2c_lcd_data_direction), RW is raised and each nibble 
+ * (each byte on the 8bit bus) is read while enable is high. The port is left 
+ * in write mode with enable low. Without an RW line nothing can be read.
+ * 
+ * @param[in]  rs    INST_REGR for busy flag and address, DATA_REGR for RAM
+ * @param[out] data  bytes read
+ * @param[in]  len   number of bytes to read
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_read(uint8_t rs, uint8_t *data, uint16_t len) {
+    if (!LCD_CAN_READ) {
+        return I2C_LCD_ERR_ABORT;
+    }
+    uint8_t idle = LCD_READ | rs | _backlight_out;
+#if !LCD_8BIT_BUS
+    idle |= DATA_PINS;
+#endif
+    i2c_lcd_status_t status = _i2c_lcd_data_direction(true);
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_write_port(idle);
+    }
+    
+    for (uint16_t i = 0; i < len && status == I2C_LCD_OK; i++) {
+        uint8_t value = 0;
+        for (uint8_t nibble = 0; nibble < (LCD_8BIT_BUS ? 1 : 2) && 
+            status == I2C_LCD_OK; nibble++) {
+            uint8_t port = 0;
+            status = _i2c_lcd_write_port(idle | LCD_ENABLE);
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_read_port(&port);
+            }
+            if (status == I2C_LCD_OK) {
+                status = _i2c_lcd_write_port(idle);
+            }
+#if LCD_8BIT_BUS
+            value = port;
+#else
+            value = (value << 4) | ((port & DATA_PINS) >> I2C_LCD_DATA_SHIFT);
+#endif
+        }
+        data[i] = value;
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_write_port(rs | _backlight_out);
+    }
+    if (status == I2C_LCD_OK) {
+        status = _i2c_lcd_data_direction(false);
+    }
+    return status;
 }
 
-static void _i2c_lcd_set_address()
-{
-    // Critical section
-    GLOBAL_INT_DISABLE();
-    i2c_set_controller_status(I2C_CONTROLLER_DISABLE);
-    // The programmer supports I2C memories with an address range between 0x00000 and 0x3FFFF (maximum size is 256KB)
-    i2c_set_target_address(I2C_LCD_ADDRESS);  // Set Slave device address
-    i2c_set_controller_status(I2C_CONTROLLER_ENABLE);
-    while (i2c_is_master_busy());               // Wait until no master activity
-    GLOBAL_INT_RESTORE();
+/**
+ ******************************************************************************
+ * Private function that checks the controller is in 4bit mode and in step by 
+ * setting two DDRAM addresses and reading each one back with the busy flag. 
+ * The addresses have opposite low nibbles so a controller that is in 8bit 
+ * mode or a nibble out of phase cannot answer both. The address counter is 
+ * moved, _ac_valid is cleared.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_probe() {
+    static const uint8_t probes[] = { 0x25, 0x0A };
+    _ac_valid = false;
+    for (uint8_t i = 0; i < sizeof(probes); i++) {
+        uint8_t value = 0xFF;
+        if (_i2c_lcd_command(LCD_SET_DDR_ADR_CMD | probes[i]) != I2C_LCD_OK) {
+            return false;
+        }
+        if (_i2c_lcd_read(INST_REGR, &value, 1) != I2C_LCD_OK) {
+            return false;
+        }
+        // Busy flag is bit 7, it must be clear by now
+        if (value != probes[i]) {
+            return false;
+        }
+    }
+    return true;
 }
 
-void _i2c_lcd_command(const uint8_t byte) {
+i2c_lcd_status_t _i2c_lcd_command(const uint8_t byte) {
+    if (_resync_needed && !_resyncing) {
+        i2c_lcd_status_t status = i2c_lcd_resync();
+        if (status != I2C_LCD_OK) {
+            return status;
+        }
+    }
     uint8_t data[1] = { byte };
-    _i2c_lcd_send(data, 1, MODE_4BIT, INST_REGR);
+    _stats.commands_sent++;
+    return _i2c_lcd_send(data, 1, MODE_4BIT, INST_REGR);
 }
 
-//@todo - explain this so I remember
-void i2c_lcd_get_8bit_cmd(uint8_t byte, uint8_t buffer[3], uint8_t rs) {
-    uint8_t b = (byte | rs) | _backlight;
-    buffer[0] = b & 0xFB; // Enable Low
-    buffer[1] = b | 0x04; // Enable High
-    buffer[2] = b & 0xFB; // Enable Low
+#if !LCD_8BIT_BUS
+/**
+ ******************************************************************************
+ * Private function that appends one 4bit character or instruction to the DMA 
+ * frame at [words], followed by the idle words that give the controller time 
+ * to execute it. Returns the new frame length.
+ ******************************************************************************
+ */
+static uint16_t _i2c_lcd_encode(uint16_t words, uint8_t byte, uint8_t rs) {
+    uint8_t cmd[6];
+    i2c_lcd_get_4bit_cmd(byte, cmd, rs);
+    for (uint8_t i = 0; i < 6; i++) {
+        _dma_frame[words++] = cmd[i];
+    }
+#if DMA_IDLE_WORDS > 0
+    // Repeating the last byte leaves enable low
+    for (uint8_t i = 0; i < DMA_IDLE_WORDS; i++) {
+        _dma_frame[words++] = cmd[5];
+    }
+#endif
+    return words;
 }
 
-//@todo - explain this so I remember
-void i2c_lcd_get_4bit_cmd(uint8_t byte, uint8_t buffer[6], uint8_t rs) {
-    uint8_t hinib = (byte & 0xF0) | rs | _backlight;
-    uint8_t lonib = (byte << 4 & 0xF0) | rs | _backlight;
-    buffer[0] = hinib & 0xFB; // Enable Low
-    buffer[1] = hinib | 0x04; // Enable High
-    buffer[2] = hinib & 0xFB; // Enable Low
-    buffer[3] = lonib & 0xFB; // Enable Low
-    buffer[4] = lonib | 0x04; // Enable High
-    buffer[5] = lonib & 0xFB; // Enable Low
+/**
+ ******************************************************************************
+ * Private function that hands the frame of [words] words to the DMA engine. 
+ * The bus is held until _i2c_lcd_dma_done, the frame must not be cut.
+ ******************************************************************************
+ */
+static void _i2c_lcd_dma_start(uint16_t words) {
+    i2c_lcd_bus_acquire(&_bus_client);
+    _dma_busy = true;
+    _dma_engine(_dma_frame, words, _i2c_lcd_dma_done, NULL, I2C_F_ADD_STOP);
+}
+
+/**
+ ******************************************************************************
+ * Private function called by the DMA engine (from interrupt context) when a 
+ * frame has left. A frame that was cut short may have left the controller 
+ * half way through a character, where it stopped is not known so the next 
+ * transfer resyncs.
+ ******************************************************************************
+ */
+static void _i2c_lcd_dma_done(void *cb_data, uint16_t len, bool success) {
+    if (len > DMA_PREFIX_WORDS) {
+        _stats.bus_bytes += len - DMA_PREFIX_WORDS;
+        _port = _dma_frame[len - 1];
+        _backlight_sent = _port & I2C_LCD_PIN_BL;
+    }
+    if (!success) {
+        _stats.aborts++;
+        _ac_valid = false;
+        _resync_needed = true;
+    }
+    _dma_busy = false;
+    i2c_lcd_bus_release(&_bus_client);
+}
+
+/**
+ ******************************************************************************
+ * Private function that waits for the DMA frame to be free and starts a 
+ * group frame in it. Returns the frame length so far.
+ ******************************************************************************
+ */
+static uint16_t _i2c_lcd_group_frame() {
+    while (_dma_busy);
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+    _dma_frame[0] = MCP23008_GPIO;
+#endif
+    return DMA_PREFIX_WORDS;
+}
+
+/**
+ ******************************************************************************
+ * Private function that appends a character or instruction to a group frame 
+ * (see _i2c_lcd_encode) with the backlight of the group instead of the one 
+ * of the LCD.
+ ******************************************************************************
+ */
+static uint16_t _i2c_lcd_group_encode(i2c_lcd_group_t *group, uint16_t words, 
+    uint8_t byte, uint8_t rs) {
+    uint16_t first = words;
+    words = _i2c_lcd_encode(words, byte, rs);
+    for (uint16_t i = first; i < words; i++) {
+        _dma_frame[i] = (_dma_frame[i] & ~I2C_LCD_PIN_BL) | 
+            BACKLIGHT_PIN(group->backlight);
+    }
+    return words;
+}
+
+/**
+ ******************************************************************************
+ * Private function that sends the frame to every display of the group, one 
+ * address after the other. The frame is not encoded again, each send waits 
+ * for the one before it to leave the bus. A display that aborts does not 
+ * stop the others.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_group_send(i2c_lcd_group_t *group, uint16_t words) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    group->bus.priority = I2C_LCD_BUS_PRIORITY;
+    for (uint8_t i = 0; i < group->count; i++) {
+        group->bus.address = group->addresses[i];
+        i2c_lcd_bus_acquire(&group->bus);
+        _dma_busy = true;
+        _dma_engine(_dma_frame, words, _i2c_lcd_group_done, group, I2C_F_ADD_STOP);
+        while (_dma_busy);
+        if (!_group_ok) {
+            group->aborts++;
+            status = I2C_LCD_ERR_ABORT;
+        }
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function called by the DMA engine when a group frame has left. The 
+ * LCD's state is not touched, the frame went to another display.
+ ******************************************************************************
+ */
+static void _i2c_lcd_group_done(void *cb_data, uint16_t len, bool success) {
+    i2c_lcd_group_t *group = cb_data;
+    if (len > DMA_PREFIX_WORDS) {
+        group->bus_bytes += len - DMA_PREFIX_WORDS;
+    }
+    _group_ok = success;
+    _dma_busy = false;
+    i2c_lcd_bus_release(&group->bus);
 }
+#endif
 
 /**
- * This method is a copy of the i2c i2c_master_transmit_buffer_sync with systick wait added
- * for the delays required by the HD44780
+ ******************************************************************************
+ * Encodes a byte for the 8bit interface. Through a 4bit expander only the 
+ * high nibble reaches the controller (used while it is brought to 4bit 
+ * mode). On the MCP23017 the strobe is one transfer that toggles between 
+ * port B and port A: data is set before enable rises and held after it falls.
+ ******************************************************************************
  */
+void i2c_lcd_get_8bit_cmd(uint8_t byte, uint8_t buffer[STROBE_BYTES], uint8_t rs) {
+#if LCD_8BIT_BUS
+    uint8_t control = rs | _backlight_out;
+    buffer[0] = control;                // Enable Low
+    buffer[1] = byte;
+    buffer[2] = control | LCD_ENABLE;   // Enable High
+    buffer[3] = byte;
+    buffer[4] = control;                // Enable Low
+#else
+    uint8_t b = DATA_NIBBLE(byte >> 4) | rs | _backlight_out;
+    buffer[0] = b & ~LCD_ENABLE; // Enable Low
+    buffer[1] = b | LCD_ENABLE;  // Enable High
+    buffer[2] = b & ~LCD_ENABLE; // Enable Low
+#endif
+}
+
+//@todo - explain this so I remember
+void i2c_lcd_get_4bit_cmd(uint8_t byte, uint8_t buffer[6], uint8_t rs) {
+    uint8_t hinib = DATA_NIBBLE(byte >> 4) | rs | _backlight_out;
+    uint8_t lonib = DATA_NIBBLE(byte) | rs | _backlight_out;
+    buffer[0] = hinib & ~LCD_ENABLE; // Enable Low
+    buffer[1] = hinib | LCD_ENABLE;  // Enable High
+    buffer[2] = hinib & ~LCD_ENABLE; // Enable Low
+    buffer[3] = lonib & ~LCD_ENABLE; // Enable Low
+    buffer[4] = lonib | LCD_ENABLE;  // Enable High
+    buffer[5] = lonib & ~LCD_ENABLE; // Enable Low
+}
+
  /**
  ******************************************************************************
  * Private function that uses the i2c driver (see i2c.h) to send data to the 
  * LCD. This method is a copy of the i2c i2c_master_transmit_buffer_sync with 
- * systick wait added for the delays required by the HD44780
+ * systick wait added for the delays required by the HD44780, only for the 
+ * part the bus does not already take (see _i2c_lcd_slack_us)
+ * 
+ * Every byte is a complete I2C transfer (it is written with a STOP, after 
+ * the GPIO register on the MCP23008) that is waited out before its abort 
+ * source is read, so a byte that was aborted never reached the expander port 
+ * and can simply be sent again. Each byte is retried up to 
+ * I2C_LCD_RETRIES times. On the MCP23017 the whole strobe is one transfer 
+ * and is retried as a whole, aborts are address NACKs so nothing of it has 
+ * reached the port.
  * 
  * @param[in] data  data pointer (typically a char array)
  * @param[in] len   length of [data] to send via i2c 
- * @note len is not checked here because it is interally set to 3 or 6
+ * @return number of bytes that reached the expander
+ * @note len is not checked here because it is interally set to 3, 5 or 6
  ******************************************************************************
  */
 uint16_t _i2c_send(const uint8_t *data, uint16_t len) {
-    i2c_abort_t abrt_code;
     i2c_abort_t ret = I2C_ABORT_NONE;
     uint16_t bytes_written = 0;
+    uint8_t retries = 0;
     
-    while (len--)
+    while (bytes_written < len)
     {
+#if LCD_8BIT_BUS
+        // The whole strobe is one transfer, sent again as a whole after an abort
+        while (!i2c_is_tx_fifo_not_full());
+        i2c_write_byte(MCP23017_GPIOB);
+        for (uint16_t i = 0; i < len; i++) {
+            while (!i2c_is_tx_fifo_not_full());
+            i2c_write_byte(data[i] | (i + 1 == len ? I2C_STOP : 0));
+        }
+        uint16_t sent = len;
+#else
+#if I2C_LCD_BACKEND == I2C_LCD_MCP23008
+        while (!i2c_is_tx_fifo_not_full());
+        i2c_write_byte(MCP23008_GPIO);
+#endif
         while (!i2c_is_tx_fifo_not_full());
         i2c_write_byte(data[bytes_written] | I2C_STOP);
-        bytes_written++;
+        uint16_t sent = 1;
+#endif
         
-        // every 3rd command wait at least 37us
-        if(bytes_written%3 == 0) {
-            systick_wait(240);
-        } else {
-            // every command needs at least 450ns for the enable pin to be read
-            systick_wait(200);
-        }
+        // The abort source is only known once the transfer has ended
+        // Wait until TX fifo is empty
+        while (!i2c_is_tx_fifo_empty());
+        // Wait until no master activity
+        while (i2c_is_master_busy());
         
         // Read tx abort source
         ret = i2c_get_abort_source();
@@ -317,20 +2418,23 @@ uint16_t _i2c_send(const uint8_t *data, uint16_t len) {
         {
             // Clear tx abort
             i2c_reset_int_tx_abort();
+            _stats.aborts++;
+            if (retries++ < I2C_LCD_RETRIES) {
+                _stats.retries++;
+                continue;
+            }
             break;
         }
-    }
-    if (!ret)
-    {
-        // Wait until TX fifo is empty
-        while (!i2c_is_tx_fifo_empty());
-        // Wait until no master activity
-        while (i2c_is_master_busy());
-    }
-    if (abrt_code)
-    {
-        // break here for debugging i2c aborts
-        abrt_code = ret;
+        bytes_written += sent;
+        _port = data[bytes_written - 1];
+        _stats.bus_bytes += sent;
+        
+        // The slack counts from the end of the byte on the wire, it may fall 
+        // in the middle of a character so it is never yielded
+        uint32_t slack = _i2c_lcd_slack_us(bytes_written - 1);
+        if (slack > 0) {
+            _i2c_lcd_spin(slack);
+        }
     }
     return bytes_written;
 }
@@ -339,41 +2443,71 @@ uint16_t _i2c_send(const uint8_t *data, uint16_t len) {
  ******************************************************************************
  * Private function that preps data in 4bit or 8bit mode for sending via i2c
  * 
+ * If a character is cut short in 4bit mode the controller may be left half 
+ * way through it (or with the enable line high) and will read every following 
+ * nibble out of phase. Even a character that never started leaves the screen 
+ * behind the RAM copy, which already holds the whole text, so every abort 
+ * schedules a resync (it repaints the screen) before the next transfer. The 
+ * address counter is not trusted until then, nothing may skip its address 
+ * command.
+ * 
  * @param[in] data  data pointer (typically a char array)
  * @param[in] len   length of [data] to print, if it is more than actual length 
  *                  of data, actual length is used.
  * @param[in] mode  MODE_4BIT or MODE_8BIT
  * @param[in] rs    INST_REGR or DATA_REGR for instruction or data registers
+ * @return I2C_LCD_OK or I2C_LCD_ERR_ABORT
  ******************************************************************************
  */
-uint16_t _i2c_lcd_send(const uint8_t *data, uint16_t len, uint8_t mode, 
+i2c_lcd_status_t _i2c_lcd_send(const uint8_t *data, uint16_t len, uint8_t mode, 
     uint8_t rs) {
     // before the data is sent we set the i2c address for the LCD
     _i2c_lcd_set_address();
     
+    i2c_lcd_status_t status = I2C_LCD_OK;
     uint16_t bytes_written = 0;
     uint16_t index = 0; 
     
-    while (index < len)
+    while (index < len && status == I2C_LCD_OK)
     {
+        // Character boundary, a transaction of a higher priority client on 
+        // a shared bus can go here
+        if (index > 0) {
+            _i2c_lcd_set_address();
+        }
         // Mode will either be MODE_4BIT (0) or MODE_8BIT (1)
         // Data is sent in 8bit mode or 4bit mode.  8bit mode is used in the 
         // initialization phase until 4bit mode is ready (see i2c_lcd_init).
         // After that, 4bit mode is used for everything.
-        if(mode == MODE_8BIT) {
-            uint8_t cmd[3];
+        // On an 8bit bus (MCP23017) there are only 8bit strobes
+        if(mode == MODE_8BIT || LCD_8BIT_BUS) {
+            uint8_t cmd[STROBE_BYTES];
             i2c_lcd_get_8bit_cmd(data[index], cmd, rs);
-            uint16_t num_bytes = _i2c_send(cmd, 3);
+            uint16_t num_bytes = _i2c_send(cmd, STROBE_BYTES);
             bytes_written += num_bytes;
+            if (num_bytes < STROBE_BYTES) {
+                status = I2C_LCD_ERR_ABORT;
+                _resync_needed = true;
+                _ac_valid = false;
+            }
         } else {
             uint8_t cmd[6];
             i2c_lcd_get_4bit_cmd(data[index], cmd, rs);
             uint16_t num_bytes = _i2c_send(cmd, 6);
             bytes_written += num_bytes;
+            if (num_bytes < 6) {
+                status = I2C_LCD_ERR_ABORT;
+                _resync_needed = true;
+                _ac_valid = false;
+            }
         }
         index++;
     }   
-    return bytes_written;
+    // Every byte carries the backlight bit
+    if (bytes_written > 0) {
+        _backlight_sent = _backlight_out;
+    }
+    return status;
 }
 
 /**
@@ -385,8 +2519,9 @@ uint16_t _i2c_lcd_send(const uint8_t *data, uint16_t len, uint8_t mode,
  * @param[in] us    microseconds to wait 
  ******************************************************************************
  */
-void _i2c_send_and_wait_8bit(uint8_t byte, uint32_t us) {
+i2c_lcd_status_t _i2c_send_and_wait_8bit(uint8_t byte, uint32_t us) {
     uint8_t data_8bit[1] = {byte};
-    _i2c_lcd_send(data_8bit, 1, MODE_8BIT, INST_REGR);
-    systick_wait(us);
+    i2c_lcd_status_t status = _i2c_lcd_send(data_8bit, 1, MODE_8BIT, INST_REGR);
+    _i2c_lcd_wait(us);
+    return status;
 }
@@ -39,7 +39,9 @@
  */
 #include <stdint.h>
 #include <stdbool.h>
+#include "i2c.h"
 #include "user_periph_setup.h"
+#include "i2c_lcd_bus.h"
 
 /**
  ****************************************************************************************
@@ -55,6 +57,11 @@
 #define LCD_FONT_5x8        0x00
 #define LCD_TWO_LINES       0x08
 #define LCD_ONE_LINE        0x00
+
+// Expanders, selected with I2C_LCD_BACKEND (see i2c_lcd.c for the pin defaults)
+#define I2C_LCD_PCF8574     0    // PCF8574/PCF8574A backpack, 4bit
+#define I2C_LCD_MCP23008    1    // MCP23008 backpack, 4bit
+#define I2C_LCD_MCP23017    2    // MCP23017, 8bit: data on port A, control on port B
  
  /**
  ****************************************************************************************
@@ -63,11 +70,15 @@
  */
 #define MODE_4BIT           0
 #define MODE_8BIT           1
-#define INST_REGR           0x00 // 4bit instruction register select
-#define DATA_REGR           0x01 // 4bit data register select 
+#define INST_REGR           0x00           // instruction register select
 #define NUM_LINES           I2C_LCD_NUM_LINES
 #define NUM_COLMS           I2C_LCD_NUM_COLS
 
+// Controller memory sizes
+#define LCD_DDRAM_SIZE      80
+#define LCD_LINE_SIZE       40   // DDRAM per line in two line mode
+#define LCD_CGRAM_SIZE      64
+
 // SET DDRAM ADDRESS Command
 #define LCD_SET_DDR_ADR_CMD 0x80
 // SET CGRAM ADDRESS Command
@@ -77,6 +88,7 @@
 #define LCD_CLEAR_CMD       0x01
 #define LCD_HOME_CMD        0x02
 #define LCD_ENTRY_MODE_CMD  0x04
+#define LCD_FUNCTION_CMD    0x20
 
 // Display Commands
 #define LCD_DISPLAY_CMD     0x08
@@ -93,6 +105,127 @@
 #define LCD_BACKLIGHT_OFF 0x00
 #define LCD_BACKLIGHT_ON  0x08
 
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * Result of the functions that talk to the LCD.
+ *
+ * I2C_LCD_ERR_ABORT means an expander byte was still aborted after I2C_LCD_RETRIES
+ * retries. The driver then resyncs the controller before the next transfer (see
+ * i2c_lcd_resync), the screen is repainted from the driver's RAM copy so the text
+ * that failed is not lost.
+ ****************************************************************************************
+ */
+typedef enum {
+    I2C_LCD_OK = 0,
+    I2C_LCD_ERR_ABORT,
+} i2c_lcd_status_t;
+
+/**
+ ****************************************************************************************
+ * How i2c_lcd_init_warm brought the LCD up.
+ ****************************************************************************************
+ */
+typedef enum {
+    I2C_LCD_START_COLD = 0, // full power up initialization (i2c_lcd_init)
+    I2C_LCD_START_WARM,     // controller was in step, state re-applied and repainted
+    I2C_LCD_START_RESYNC,   // controller was out of step, resynced and repainted
+} i2c_lcd_start_t;
+
+/**
+ ****************************************************************************************
+ * What the application knows about the LCD supply when it wakes up.
+ ****************************************************************************************
+ */
+typedef enum {
+    I2C_LCD_POWER_KEPT = 0, // LCD stayed powered during sleep
+    I2C_LCD_POWER_LOST,     // LCD supply was gated
+    I2C_LCD_POWER_UNKNOWN,  // let the driver find out by reading the controller back
+} i2c_lcd_power_t;
+
+/**
+ ****************************************************************************************
+ * How i2c_lcd_wake restored the LCD and what it cost.
+ ****************************************************************************************
+ */
+typedef enum {
+    I2C_LCD_RESTORE_NONE = 0, // LCD kept its state, nothing written
+    I2C_LCD_RESTORE_RESYNC,   // controller out of step, resynced and repainted
+    I2C_LCD_RESTORE_FULL,     // power up sequence and repaint of glyphs and text
+} i2c_lcd_restore_path_t;
+
+typedef struct {
+    i2c_lcd_restore_path_t path;
+    uint32_t bytes;             // expander bytes on the bus
+    uint32_t us;                // time spent in HD44780 waits
+} i2c_lcd_restore_t;
+
+/**
+ ****************************************************************************************
+ * Command counters kept by the driver. Commands are elided when the controller is
+ * already known to be in the requested state (e.g. setting the cursor to the address
+ * the address counter already holds) and merged when several display control changes
+ * are made inside an i2c_lcd_batch_begin/i2c_lcd_batch_end pair.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint32_t commands_sent;     // instructions that went out on the bus
+    uint32_t commands_elided;   // instructions dropped as redundant
+    uint32_t commands_merged;   // instructions folded into a later one in a batch
+    uint32_t cells_elided;      // cells i2c_lcd_update found already on screen
+    uint32_t aborts;            // expander bytes aborted on the bus
+    uint32_t retries;           // expander bytes sent again after an abort
+    uint32_t resyncs;           // times the 4bit nibble phase was restored
+    uint32_t bus_bytes;         // expander bytes written and read
+    uint32_t wait_us;           // time spent in the driver's HD44780 waits
+    uint32_t yields;            // waits handed to the yield callback
+    uint32_t yield_us;          // part of wait_us the yield callback used
+    uint32_t scrub_checked;     // DDRAM cells read back by i2c_lcd_scrub
+    uint32_t scrub_mismatches;  // cells rewritten by i2c_lcd_scrub, plus mode losses
+} i2c_lcd_stats_t;
+
+/**
+ ****************************************************************************************
+ * Engine that sends a DMA frame: i2c_master_transmit_buffer_dma when the SDK is built
+ * with CFG_I2C_DMA_SUPPORT, i2c_lcd_dma_standin otherwise. [cb] must be called once
+ * the frame has left (or was aborted) with the number of words sent.
+ ****************************************************************************************
+ */
+typedef void (*i2c_lcd_dma_engine_t)(uint16_t *data, uint16_t len, 
+    i2c_complete_cb_t cb, void *cb_data, uint32_t flags);
+
+/**
+ ****************************************************************************************
+ * Displays that show the same content, each on its own expander address (see 
+ * i2c_lcd_group_print). Set addresses, count and backlight, leave the rest zero. The 
+ * LCD at I2C_LCD_ADDRESS must not be in the group, its RAM copy would go stale.
+ ****************************************************************************************
+ */
+typedef struct {
+    const uint16_t *addresses;  // expander addresses of the displays
+    uint8_t  count;             // number of addresses
+    bool     backlight;         // backlight of every display, taken by the next frame
+    // Owned by the driver
+    uint8_t  glyphs[8][8];      // CGRAM the group was sent, see glyph_mask
+    uint8_t  glyph_mask;        // bit per location that is in glyphs
+    uint32_t bus_bytes;         // expander bytes sent, all displays together
+    uint32_t aborts;            // frames a display did not take
+    i2c_lcd_bus_client_t bus;   // the group on the shared bus, one address at a time
+} i2c_lcd_group_t;
+
+/**
+ ****************************************************************************************
+ * Called instead of a busy wait (see i2c_lcd_set_yield). [us] is the time the driver 
+ * has to wait, the callback may run background work or sleep for up to that long and 
+ * returns the time it used. What is left is waited out by the driver.
+ ****************************************************************************************
+ */
+typedef uint32_t (*i2c_lcd_yield_t)(uint32_t us);
+
 /*
  * FUNCTION DECLARATIONS
  ****************************************************************************************
@@ -109,7 +242,41 @@
  * interface. See source file for initialization steps.
  ****************************************************************************************
  */
-void i2c_lcd_init(void);
+i2c_lcd_status_t i2c_lcd_init(void);
+
+ /**
+ ****************************************************************************************
+ * Warm initialization for i2c_lcd.
+ *
+ * Use instead of i2c_lcd_init after an MCU-only reset or a wakeup where the LCD may
+ * have stayed powered. The driver state lives in retention RAM (I2C_LCD_RETAINED,
+ * the uninitialized retention area by default); if it holds a completed
+ * initialization and the controller reads back two DDRAM addresses correctly in 4bit
+ * mode, the power up sequence (50ms + 3 x 4.5ms) is skipped and only the display
+ * settings are re-applied and the screen repainted from the RAM copy. Falls back to
+ * i2c_lcd_resync and then to i2c_lcd_init when the controller does not answer.
+ *
+ * @param[out] start path that was taken, can be NULL
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_init_warm(i2c_lcd_start_t *start);
+
+ /**
+ ****************************************************************************************
+ * Restores the LCD after sleep.
+ *
+ * The screen contents, custom characters and display settings are kept in the
+ * retention RAM block (about 160 bytes) so nothing has to be saved before sleeping.
+ * With I2C_LCD_POWER_KEPT nothing is written. With I2C_LCD_POWER_LOST the power up
+ * sequence is run and only the custom characters in use and the runs of non blank
+ * text are written back. With I2C_LCD_POWER_UNKNOWN the controller is read back first
+ * (a few bytes) to pick between the two, or a resync if it is out of step.
+ *
+ * @param[in]  power    what is known about the LCD supply
+ * @param[out] restore  path taken and its cost, can be NULL
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_wake(i2c_lcd_power_t power, i2c_lcd_restore_t *restore);
 
  /**
  ****************************************************************************************
@@ -119,7 +286,7 @@ void i2c_lcd_init(void);
  * @param[in] length length of data to print
  ****************************************************************************************
  */
-void i2c_lcd_print(uint8_t *data, uint8_t length);
+i2c_lcd_status_t i2c_lcd_print(uint8_t *data, uint8_t length);
 
  /**
  ****************************************************************************************
@@ -129,14 +296,32 @@ void i2c_lcd_print(uint8_t *data, uint8_t length);
  * @param[in] row row number, zero indexed
  ****************************************************************************************
  */
-void i2c_lcd_set_cursor(uint8_t col, uint8_t row);
+i2c_lcd_status_t i2c_lcd_set_cursor(uint8_t col, uint8_t row);
+
+ /**
+ ****************************************************************************************
+ * Puts an array of chars on the LCD screen at col and row, only the cells that differ
+ * from what is already on screen are written.
+ *
+ * The driver keeps a RAM copy of DDRAM so unchanged cells cost nothing on the bus. The
+ * data is cut at the end of the DDRAM line and the cursor is left after the last cell
+ * written.
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_update(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length);
 
  /**
  ****************************************************************************************
  * Clear the LCD screen
  ****************************************************************************************
  */
-void i2c_lcd_clear(void);
+i2c_lcd_status_t i2c_lcd_clear(void);
 
  /**
  ****************************************************************************************
@@ -149,90 +334,420 @@ void i2c_lcd_clear(void);
  * @param length length of the line to clear
  ****************************************************************************************
  */
-void i2c_lcd_clear_line(uint8_t length);
+i2c_lcd_status_t i2c_lcd_clear_line(uint8_t length);
 
  /**
  ****************************************************************************************
  * Turns the LCD backlight on
  ****************************************************************************************
  */
-void i2c_lcd_backlight_on(void);
+i2c_lcd_status_t i2c_lcd_backlight_on(void);
 
  /**
  ****************************************************************************************
  * Turns the LCD backlight off
  ****************************************************************************************
  */
-void i2c_lcd_backlight_off(void);
+i2c_lcd_status_t i2c_lcd_backlight_off(void);
+
+ /**
+ ****************************************************************************************
+ * Starts a backlight pattern (blink, flash, etc).
+ *
+ * The pattern is played from bit 0 upwards, one bit per step, 1 is on and 0 is off.
+ * Only the transitions are written to the LCD and each one is a single expander byte.
+ * The pattern is advanced by i2c_lcd_backlight_tick. When it stops the backlight goes
+ * back to the state set with i2c_lcd_backlight_on/off.
+ *
+ * Example, two short flashes every second: pattern 0x05, length 10, step_ms 100
+ *
+ * @param[in] pattern bits to play
+ * @param[in] length  number of bits in the pattern (1-32)
+ * @param[in] step_ms duration of one bit in milliseconds
+ * @param[in] repeat  number of times to play the pattern, 0 plays it until stopped
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_backlight_pattern(uint32_t pattern, uint8_t length, 
+    uint16_t step_ms, uint8_t repeat);
+
+ /**
+ ****************************************************************************************
+ * Blinks the backlight until i2c_lcd_backlight_pattern_stop is called
+ *
+ * @param[in] period_ms duration of one on/off cycle in milliseconds
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_backlight_blink(uint16_t period_ms);
+
+ /**
+ ****************************************************************************************
+ * Stops the backlight pattern and restores the backlight on/off state
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_backlight_pattern_stop(void);
+
+ /**
+ ****************************************************************************************
+ * Advances the backlight pattern. Call it periodically (from the main loop or a timer
+ * callback) with a millisecond time base, it only touches the bus on a transition.
+ *
+ * @param[in] now_ms current time in milliseconds
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_backlight_tick(uint32_t now_ms);
 
  /**
  ****************************************************************************************
  * Shifts the contents of the screen to the right withought modifying the DDRAM
  ****************************************************************************************
  */
-void i2c_lcd_shift_right(void);
+i2c_lcd_status_t i2c_lcd_shift_right(void);
 
  /**
  ****************************************************************************************
  * Shifts the contents of the screen to the left withought modifying the DDRAM
  ****************************************************************************************
  */
-void i2c_lcd_shift_left(void);
+i2c_lcd_status_t i2c_lcd_shift_left(void);
 
  /**
  ****************************************************************************************
  * Places the cursor at col 0, row 0
  ****************************************************************************************
  */
-void i2c_lcd_home(void);
+i2c_lcd_status_t i2c_lcd_home(void);
 
  /**
  ****************************************************************************************
  * Turns off the LCD display (makes the text disappear).
  ****************************************************************************************
  */
-void i2c_lcd_display_on(void);
+i2c_lcd_status_t i2c_lcd_display_on(void);
 
  /**
  ****************************************************************************************
  * Turns on the LCD display (makes the text reappear).
  ****************************************************************************************
  */
-void i2c_lcd_display_off(void);
+i2c_lcd_status_t i2c_lcd_display_off(void);
 
  /**
  ****************************************************************************************
  * Starts blinking the cursor (typically a rectangle)
  ****************************************************************************************
  */
-void i2c_lcd_blink_on(void);
+i2c_lcd_status_t i2c_lcd_blink_on(void);
 
  /**
  ****************************************************************************************
  * Stops the blinking cursor
  ****************************************************************************************
  */
-void i2c_lcd_blink_off(void);
+i2c_lcd_status_t i2c_lcd_blink_off(void);
 
  /**
  ****************************************************************************************
  * Displays the cursor at the current position (typically an underline)
  ****************************************************************************************
  */
-void i2c_lcd_cursor_on(void);
+i2c_lcd_status_t i2c_lcd_cursor_on(void);
 
  /**
  ****************************************************************************************
  * Turns the cursor off
  ****************************************************************************************
  */
-void i2c_lcd_cursor_off(void);
+i2c_lcd_status_t i2c_lcd_cursor_off(void);
+
+ /**
+ ****************************************************************************************
+ * Creates a custom character, only the rows that differ from what the location holds
+ * are written
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_create_char(uint8_t,  const uint8_t *charmap);
+
+ /**
+ ****************************************************************************************
+ * Tells if a custom character is used anywhere in DDRAM, replacing it would change
+ * what is on screen
+ *
+ * @param[in] location CGRAM location 0-7
+ ****************************************************************************************
+ */
+bool i2c_lcd_char_on_screen(uint8_t location);
+
+ /**
+ ****************************************************************************************
+ * Tells if a location already holds [charmap], i2c_lcd_create_char would then write
+ * nothing
+ *
+ * @param[in] location CGRAM location 0-7
+ * @param[in] charmap  8 rows of 5 pixels
+ ****************************************************************************************
+ */
+bool i2c_lcd_char_matches(uint8_t location, const uint8_t *charmap);
+
+ /**
+ ****************************************************************************************
+ * Text flows from left to right (address counter increments)
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_left_to_right(void);
+
+ /**
+ ****************************************************************************************
+ * Text flows from right to left (address counter decrements)
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_right_to_left(void);
+
+ /**
+ ****************************************************************************************
+ * Shifts the display on every character written so the cursor stays in place
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_autoscroll_on(void);
+
+ /**
+ ****************************************************************************************
+ * Stops shifting the display when characters are written
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_autoscroll_off(void);
+
+ /**
+ ****************************************************************************************
+ * Starts a batch of display control changes.
+ *
+ * Display on/off, cursor and blink changes made inside a batch are held back and sent
+ * as a single display control command by i2c_lcd_batch_end. A backlight change is only
+ * written if no other traffic in the batch has carried it already. Batches can be
+ * nested, only the outermost i2c_lcd_batch_end sends.
+ ****************************************************************************************
+ */
+void i2c_lcd_batch_begin(void);
+
+ /**
+ ****************************************************************************************
+ * Ends a batch started with i2c_lcd_batch_begin and sends the merged display control
+ * command if the controller state actually changed.
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_batch_end(void);
+
+ /**
+ ****************************************************************************************
+ * Restores the 4bit nibble phase and repaints the screen without the power up
+ * initialization.
+ *
+ * Three 8bit function sets followed by the switch to 4bit mode bring the controller
+ * back in step whatever nibble it was waiting for, then the function set, display
+ * control and entry mode are sent again and CGRAM and DDRAM are repainted from the
+ * driver's RAM copy. Takes a few milliseconds plus the repaint instead of the 60+ ms
+ * of i2c_lcd_init. Called automatically before the next transfer after an abort.
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_resync(void);
+
+ /**
+ ****************************************************************************************
+ * Puts an array of chars in the deferred screen at col and row, nothing is sent.
+ *
+ * The deferred screen starts as a copy of what is on the LCD. Cells that differ from
+ * the LCD are pending and are sent by i2c_lcd_flush_budget. Writing through the other
+ * functions (print, update) keeps the deferred screen in step, i2c_lcd_clear and
+ * i2c_lcd_init drop the pending cells.
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ ****************************************************************************************
+ */
+void i2c_lcd_defer(uint8_t col, uint8_t row, const uint8_t *data, uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Marks cells of the deferred screen as important, their pending changes are sent
+ * before the others
+ *
+ * @param[in] col       column number, zero indexed
+ * @param[in] row       row number, zero indexed
+ * @param[in] length    number of cells
+ * @param[in] important true to flush these cells first
+ ****************************************************************************************
+ */
+void i2c_lcd_set_priority(uint8_t col, uint8_t row, uint8_t length, bool important);
+
+ /**
+ ****************************************************************************************
+ * Sends pending cells for at most us microseconds.
+ *
+ * Meant for the gap between radio events: the time of every write is planned with the
+ * driver's own byte timing and the flush stops before the budget would be overrun.
+ * Important cells go first, the next call goes on from where this one stopped.
+ *
+ * @param[in] us time budget in microseconds
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_flush_budget(uint32_t us);
+
+ /**
+ ****************************************************************************************
+ * Returns the number of deferred cells that still have to be sent
+ ****************************************************************************************
+ */
+uint8_t i2c_lcd_pending(void);
+
+ /**
+ ****************************************************************************************
+ * Reads part of the screen back and repairs the cells that do not match.
+ *
+ * Call it periodically (from the main loop or a timer callback) with a millisecond
+ * time base. It does nothing until I2C_LCD_SCRUB_PERIOD_MS (100) has passed since the
+ * last read, then reads I2C_LCD_SCRUB_CELLS (8) cells of DDRAM through the expander
+ * and compares them with the driver's RAM copy, moving on to the next cells on the
+ * next call. Only the cells that do not match are written. If the controller has lost
+ * its 4bit mode (e.g. after ESD) it is resynced and the whole screen repainted. The
+ * cells checked and repaired are counted in i2c_lcd_stats_t.
+ *
+ * Needs the RW line of the expander to be wired to the LCD (it is on the common
+ * backpacks).
+ *
+ * @param[in] now_ms current time in milliseconds
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_scrub(uint32_t now_ms);
+
+ /**
+ ****************************************************************************************
+ * Writes an array of chars at col and row like i2c_lcd_update, but the changed cells
+ * are encoded into one frame of expander bytes that is sent by DMA. Returns as soon as
+ * the frame is started, the CPU is free while it is on the bus.
+ *
+ * Waits for the previous frame first, so does every other function that uses the bus.
+ * A frame holds I2C_LCD_DMA_CHARS (24) characters including the address commands,
+ * more changed cells are sent as several frames and only the last one runs in the
+ * background. A frame that is aborted is repaired by a resync before the next transfer.
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_update_dma(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Returns true while a DMA frame is on the bus
+ ****************************************************************************************
+ */
+bool i2c_lcd_dma_busy(void);
+
+ /**
+ ****************************************************************************************
+ * Replaces the engine that sends DMA frames, e.g. with a host side model
+ *
+ * @param[in] engine function that takes over the frames
+ ****************************************************************************************
+ */
+void i2c_lcd_dma_set_engine(i2c_lcd_dma_engine_t engine);
+
+ /**
+ ****************************************************************************************
+ * Stand-in DMA engine that feeds the frame to the I2C FIFO from the CPU and waits the
+ * time the frame takes on the wire. Used when CFG_I2C_DMA_SUPPORT is not defined.
+ ****************************************************************************************
+ */
+void i2c_lcd_dma_standin(uint16_t *data, uint16_t len, i2c_complete_cb_t cb, 
+    void *cb_data, uint32_t flags);
+
+ /**
+ ****************************************************************************************
+ * Runs the initialization sequence on every display of a group. The steps go to all 
+ * the displays before each wait, so the waits are not repeated per display.
+ *
+ * The group functions encode a frame once and send the same frame to each address 
+ * in turn through the DMA engine. They need a 4bit expander, with I2C_LCD_MCP23017 
+ * they return I2C_LCD_ERR_ABORT. A display that aborts a frame is counted in aborts 
+ * and may be out of step until the group is initialized again.
+ *
+ * @param[in] group displays to initialize
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_group_init(i2c_lcd_group_t *group);
+
+ /**
+ ****************************************************************************************
+ * Writes text at col and row on every display of a group. Nothing is known of what 
+ * the displays show, so every character is sent. Text past the end of the line is 
+ * cut.
+ *
+ * @param[in] group  displays to write
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_group_print(i2c_lcd_group_t *group, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Creates a custom character on every display of a group. A glyph the group already 
+ * has at [location] is not sent again.
+ *
+ * @param[in] group    displays to write
+ * @param[in] location CGRAM location 0-7
+ * @param[in] charmap  8 rows of 5 pixels
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_group_create_char(i2c_lcd_group_t *group, uint8_t location, 
+    const uint8_t *charmap);
+
+ /**
+ ****************************************************************************************
+ * Hands the driver's waits of [min_us] or more to [yield] instead of spinning: the 
+ * power up sequence (50ms and two 4.5ms waits), clear and home (2ms) and the like. 
+ * A zero wait is never handed over. The waits inside a character (the execution 
+ * time the bus does not cover) stay busy waits whatever [min_us] is.
+ *
+ * The callback runs between two LCD transfers, it must not use the LCD. Jobs on the 
+ * shared bus (i2c_lcd_bus_run) are fine, the LCD selects its address again before its 
+ * next transfer.
+ *
+ * @param[in] yield  callback, NULL to spin again
+ * @param[in] min_us shortest wait handed to the callback
+ ****************************************************************************************
+ */
+void i2c_lcd_set_yield(i2c_lcd_yield_t yield, uint32_t min_us);
+
+ /**
+ ****************************************************************************************
+ * Returns the LCD's client on the shared bus, for its wait counters (see 
+ * i2c_lcd_bus_get_stats). The priority can be changed between transfers.
+ ****************************************************************************************
+ */
+i2c_lcd_bus_client_t *i2c_lcd_get_bus_client(void);
+
+ /**
+ ****************************************************************************************
+ * Copies the command counters
+ *
+ * @param[out] stats destination for the counters
+ ****************************************************************************************
+ */
+void i2c_lcd_get_stats(i2c_lcd_stats_t *stats);
 
  /**
  ****************************************************************************************
- * Creates a custom character
+ * Resets the command counters to zero
  ****************************************************************************************
  */
-void i2c_lcd_create_char(uint8_t,  uint8_t *charmap);
+void i2c_lcd_reset_stats(void);
 
 #endif // _I2C_LCD_H_
@@ -0,0 +1,130 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_bar.c
+ *
+ * @brief Bar graphs and progress bars with partial cell glyphs.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include "i2c_lcd.h"
+#include "i2c_lcd_bar.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+// First CGRAM location used for the partial cell glyphs
+#ifndef I2C_LCD_BAR_BASE
+#define I2C_LCD_BAR_BASE    0
+#endif
+
+#define BAR_FULL            0xFF // full block from the character ROM
+#define BAR_EMPTY           ' '
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static i2c_lcd_status_t _i2c_lcd_bar_glyph(uint8_t orientation, uint8_t pixels, 
+    uint8_t *cell);
+
+/*-------------------------------------------------------------------------- */
+/* Bar Graph API Functions                                                   */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * The bar is rendered as full cells, at most one partial cell and empty cells 
+ * and handed to i2c_lcd_update which only writes the cells that changed. The 
+ * partial glyph is uploaded before it is put on screen, create_char drops 
+ * the upload if the glyph is already resident.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_bar_set(const i2c_lcd_bar_t *bar, uint16_t value, uint16_t max) {
+    uint8_t cells[LCD_LINE_SIZE];
+    uint8_t length = bar->length > LCD_LINE_SIZE ? LCD_LINE_SIZE : bar->length;
+    uint8_t resolution = bar->orientation == I2C_LCD_BAR_VERTICAL ? 8 : 5;
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    
+    if (value > max) {
+        value = max;
+    }
+    uint16_t pixels = max == 0 ? 0 : (uint32_t)value * length * resolution / max;
+    for (uint8_t i = 0; i < length && status == I2C_LCD_OK; i++) {
+        if (pixels >= resolution) {
+            cells[i] = BAR_FULL;
+            pixels -= resolution;
+        } else if (pixels > 0) {
+            status = _i2c_lcd_bar_glyph(bar->orientation, pixels, &cells[i]);
+            pixels = 0;
+        } else {
+            cells[i] = BAR_EMPTY;
+        }
+    }
+    
+    if (bar->orientation != I2C_LCD_BAR_VERTICAL) {
+        if (status == I2C_LCD_OK) {
+            status = i2c_lcd_update(bar->col, bar->row, cells, length);
+        }
+        return status;
+    }
+    // Vertical bars fill from the bottom row up
+    for (uint8_t i = 0; i < length && i <= bar->row && status == I2C_LCD_OK; i++) {
+        status = i2c_lcd_update(bar->col, bar->row - i, &cells[i], 1);
+    }
+    return status;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that makes sure the glyph for a partial cell is in CGRAM. 
+ * A horizontal glyph has the [pixels] left columns set, a vertical glyph the 
+ * [pixels] bottom rows.
+ * 
+ * @param[in]  orientation  I2C_LCD_BAR_HORIZONTAL or I2C_LCD_BAR_VERTICAL
+ * @param[in]  pixels       filled pixels in the cell, 1-4 or 1-7
+ * @param[out] cell         character code of the glyph
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_bar_glyph(uint8_t orientation, uint8_t pixels, 
+    uint8_t *cell) {
+    uint8_t charmap[8];
+    for (uint8_t row = 0; row < 8; row++) {
+        if (orientation == I2C_LCD_BAR_VERTICAL) {
+            charmap[row] = row >= 8 - pixels ? 0x1F : 0x00;
+        } else {
+            charmap[row] = (0x1F << (5 - pixels)) & 0x1F;
+        }
+    }
+    *cell = (I2C_LCD_BAR_BASE + pixels - 1) & 0x07;
+    return i2c_lcd_create_char(*cell, charmap);
+}
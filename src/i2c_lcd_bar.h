@@ -0,0 +1,94 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_bar.h
+ * @brief   Bar graphs for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_BAR_H_
+#define _I2C_LCD_BAR_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+#define I2C_LCD_BAR_HORIZONTAL  0
+#define I2C_LCD_BAR_VERTICAL    1
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * Position and size of a bar. A horizontal bar grows to the right from col on row, a
+ * vertical bar grows upwards from row (its bottom row) in col.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+    uint8_t length;             // cells
+    uint8_t orientation;        // I2C_LCD_BAR_HORIZONTAL or I2C_LCD_BAR_VERTICAL
+} i2c_lcd_bar_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Sets a bar (or progress bar) to value out of max.
+ *
+ * Horizontal bars have a resolution of 5 pixels per cell, vertical bars 8 pixels per
+ * cell. Full cells use the ROM full block and the partial cell one of the custom
+ * characters at I2C_LCD_BAR_BASE (4 horizontal glyphs, 7 vertical glyphs, each one
+ * uploaded the first time it is needed). Only the partial cell and the cells that
+ * changed between full and empty are written.
+ *
+ * Every cell showing a partial glyph changes with it, so horizontal and vertical bars
+ * or large numerals can only share the screen if I2C_LCD_BAR_BASE keeps them apart.
+ *
+ * @param[in] bar   bar to set
+ * @param[in] value filled part, clamped to max
+ * @param[in] max   value of a full bar, a progress bar in percent uses 100
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_bar_set(const i2c_lcd_bar_t *bar, uint16_t value, uint16_t max);
+
+#endif // _I2C_LCD_BAR_H_
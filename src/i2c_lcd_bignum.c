@@ -0,0 +1,240 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_bignum.c
+ *
+ * @brief Large numerals built from CGRAM segment glyphs.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include <stddef.h>
+#include "i2c_lcd.h"
+#include "i2c_lcd_bignum.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+// Blank columns between two large characters
+#ifndef I2C_LCD_BIGNUM_GAP
+#define I2C_LCD_BIGNUM_GAP  1
+#endif
+
+// ROM character used for the colon dots, 0xA5 is a centered dot in the A00 ROM
+#ifndef I2C_LCD_BIGNUM_DOT
+#define I2C_LCD_BIGNUM_DOT  0xA5
+#endif
+
+#define BIGNUM_MAX_COLS     LCD_LINE_SIZE
+#define BIGNUM_CHARS        14
+
+// Segment glyphs, the value is the CGRAM location
+#define SEG_LT              0x00 // full cell, upper left corner rounded
+#define SEG_UB              0x01 // upper bar
+#define SEG_RT              0x02 // full cell, upper right corner rounded
+#define SEG_LL              0x03 // full cell, lower left corner rounded
+#define SEG_LB              0x04 // lower bar
+#define SEG_LR              0x05 // full cell, lower right corner rounded
+#define SEG_UMB             0x06 // upper bar and middle bar top half
+#define SEG_LMB             0x07 // middle bar bottom half and lower bar
+#define SEG_FB              0xFF // full block from the character ROM
+#define SEG_SP              ' '
+#define SEG_DT              I2C_LCD_BIGNUM_DOT
+
+static const uint8_t _segments[8][8] = {
+    { 0x07, 0x0F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }, // SEG_LT
+    { 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00 }, // SEG_UB
+    { 0x1C, 0x1E, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }, // SEG_RT
+    { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x0F, 0x07 }, // SEG_LL
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F }, // SEG_LB
+    { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1E, 0x1C }, // SEG_LR
+    { 0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x1F, 0x1F }, // SEG_UMB
+    { 0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F }, // SEG_LMB
+};
+
+// 0-9, ':', '-', '.' and ' '
+static const uint8_t _widths[BIGNUM_CHARS] = { 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 1, 2, 1, 3 };
+
+static const uint8_t _chars_2row[BIGNUM_CHARS][2][3] = {
+    { { SEG_LT,  SEG_UB,  SEG_RT  }, { SEG_LL,  SEG_LB,  SEG_LR  } }, // 0
+    { { SEG_UB,  SEG_RT,  SEG_SP  }, { SEG_LB,  SEG_FB,  SEG_LB  } }, // 1
+    { { SEG_UMB, SEG_UMB, SEG_RT  }, { SEG_LL,  SEG_LMB, SEG_LMB } }, // 2
+    { { SEG_UMB, SEG_UMB, SEG_RT  }, { SEG_LMB, SEG_LMB, SEG_LR  } }, // 3
+    { { SEG_LL,  SEG_LB,  SEG_FB  }, { SEG_SP,  SEG_SP,  SEG_FB  } }, // 4
+    { { SEG_FB,  SEG_UMB, SEG_UMB }, { SEG_LMB, SEG_LMB, SEG_LR  } }, // 5
+    { { SEG_LT,  SEG_UMB, SEG_UMB }, { SEG_LL,  SEG_LMB, SEG_LR  } }, // 6
+    { { SEG_UB,  SEG_UB,  SEG_RT  }, { SEG_SP,  SEG_SP,  SEG_FB  } }, // 7
+    { { SEG_LT,  SEG_UMB, SEG_RT  }, { SEG_LL,  SEG_LMB, SEG_LR  } }, // 8
+    { { SEG_LT,  SEG_UMB, SEG_RT  }, { SEG_LMB, SEG_LMB, SEG_LR  } }, // 9
+    { { SEG_DT                    }, { SEG_DT                    } }, // :
+    { { SEG_LB,  SEG_LB           }, { SEG_SP,  SEG_SP           } }, // -
+    { { SEG_SP                    }, { SEG_LB                    } }, // .
+    { { SEG_SP,  SEG_SP,  SEG_SP  }, { SEG_SP,  SEG_SP,  SEG_SP  } }, // ' '
+};
+
+static const uint8_t _chars_4row[BIGNUM_CHARS][4][3] = {
+    { { SEG_LT,  SEG_UB,  SEG_RT  }, { SEG_FB,  SEG_SP,  SEG_FB  },   // 0
+      { SEG_FB,  SEG_SP,  SEG_FB  }, { SEG_LL,  SEG_LB,  SEG_LR  } },
+    { { SEG_UB,  SEG_FB,  SEG_SP  }, { SEG_SP,  SEG_FB,  SEG_SP  },   // 1
+      { SEG_SP,  SEG_FB,  SEG_SP  }, { SEG_LB,  SEG_FB,  SEG_LB  } },
+    { { SEG_UB,  SEG_UB,  SEG_RT  }, { SEG_LB,  SEG_LB,  SEG_LR  },   // 2
+      { SEG_FB,  SEG_SP,  SEG_SP  }, { SEG_FB,  SEG_LB,  SEG_LB  } },
+    { { SEG_UB,  SEG_UB,  SEG_RT  }, { SEG_SP,  SEG_LB,  SEG_FB  },   // 3
+      { SEG_SP,  SEG_SP,  SEG_FB  }, { SEG_LB,  SEG_LB,  SEG_LR  } },
+    { { SEG_FB,  SEG_SP,  SEG_FB  }, { SEG_LL,  SEG_LB,  SEG_FB  },   // 4
+      { SEG_SP,  SEG_SP,  SEG_FB  }, { SEG_SP,  SEG_SP,  SEG_FB  } },
+    { { SEG_FB,  SEG_UB,  SEG_UB  }, { SEG_LL,  SEG_LB,  SEG_LB  },   // 5
+      { SEG_SP,  SEG_SP,  SEG_RT  }, { SEG_LB,  SEG_LB,  SEG_LR  } },
+    { { SEG_LT,  SEG_UB,  SEG_UB  }, { SEG_FB,  SEG_LB,  SEG_LB  },   // 6
+      { SEG_FB,  SEG_SP,  SEG_RT  }, { SEG_LL,  SEG_LB,  SEG_LR  } },
+    { { SEG_UB,  SEG_UB,  SEG_RT  }, { SEG_SP,  SEG_SP,  SEG_FB  },   // 7
+      { SEG_SP,  SEG_SP,  SEG_FB  }, { SEG_SP,  SEG_SP,  SEG_FB  } },
+    { { SEG_LT,  SEG_UB,  SEG_RT  }, { SEG_LL,  SEG_LB,  SEG_LR  },   // 8
+      { SEG_FB,  SEG_SP,  SEG_FB  }, { SEG_LL,  SEG_LB,  SEG_LR  } },
+    { { SEG_LT,  SEG_UB,  SEG_RT  }, { SEG_LL,  SEG_LB,  SEG_FB  },   // 9
+      { SEG_SP,  SEG_SP,  SEG_FB  }, { SEG_LB,  SEG_LB,  SEG_LR  } },
+    { { SEG_SP                    }, { SEG_DT                    },   // :
+      { SEG_DT                    }, { SEG_SP                    } },
+    { { SEG_SP,  SEG_SP           }, { SEG_LB,  SEG_LB           },   // -
+      { SEG_SP,  SEG_SP           }, { SEG_SP,  SEG_SP           } },
+    { { SEG_SP                    }, { SEG_SP                    },   // .
+      { SEG_SP                    }, { SEG_LB                    } },
+    { { SEG_SP,  SEG_SP,  SEG_SP  }, { SEG_SP,  SEG_SP,  SEG_SP  },   // ' '
+      { SEG_SP,  SEG_SP,  SEG_SP  }, { SEG_SP,  SEG_SP,  SEG_SP  } },
+};
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static int8_t _i2c_lcd_bignum_index(uint8_t ch);
+
+/*-------------------------------------------------------------------------- */
+/* Large Numeral API Functions                                               */ 
+/*---------------------------------------------------------------------------*/
+
+i2c_lcd_status_t i2c_lcd_bignum_load() {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    for (uint8_t location = 0; location < 8 && status == I2C_LCD_OK; location++) {
+        status = i2c_lcd_create_char(location, _segments[location]);
+    }
+    return status;
+}
+
+uint8_t i2c_lcd_bignum_width(const uint8_t *text, uint8_t length) {
+    uint8_t width = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        int8_t index = _i2c_lcd_bignum_index(text[i]);
+        if (index < 0) {
+            continue;
+        }
+        if (width > 0) {
+            width += I2C_LCD_BIGNUM_GAP;
+        }
+        width += _widths[index];
+    }
+    return width;
+}
+
+/**
+ ******************************************************************************
+ * Renders the whole area into a buffer per row (blank where there is no text) 
+ * and hands each row to i2c_lcd_update, which only writes the cells that 
+ * differ from the screen. A digit that did not change costs nothing.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_bignum_print(const i2c_lcd_bignum_t *area, const uint8_t *text, 
+    uint8_t length) {
+    uint8_t cells[4][BIGNUM_MAX_COLS];
+    uint8_t height = area->height >= 4 ? 4 : 2;
+    uint8_t width = area->width > BIGNUM_MAX_COLS ? BIGNUM_MAX_COLS : area->width;
+    uint8_t col = 0;
+    
+    for (uint8_t row = 0; row < height; row++) {
+        for (uint8_t i = 0; i < width; i++) {
+            cells[row][i] = ' ';
+        }
+    }
+    if (area->align == I2C_LCD_BIGNUM_RIGHT) {
+        uint8_t used = i2c_lcd_bignum_width(text, length);
+        col = used < width ? width - used : 0;
+    }
+    
+    bool first = true;
+    for (uint8_t i = 0; i < length; i++) {
+        int8_t index = _i2c_lcd_bignum_index(text[i]);
+        if (index < 0) {
+            continue;
+        }
+        if (!first) {
+            col += I2C_LCD_BIGNUM_GAP;
+        }
+        first = false;
+        if (col + _widths[index] > width) {
+            break;
+        }
+        for (uint8_t row = 0; row < height; row++) {
+            const uint8_t *glyph = height == 4 ? _chars_4row[index][row] : 
+                _chars_2row[index][row];
+            for (uint8_t j = 0; j < _widths[index]; j++) {
+                cells[row][col + j] = glyph[j];
+            }
+        }
+        col += _widths[index];
+    }
+    
+    i2c_lcd_status_t status = i2c_lcd_bignum_load();
+    for (uint8_t row = 0; row < height && status == I2C_LCD_OK; row++) {
+        status = i2c_lcd_update(area->col, area->row + row, cells[row], width);
+    }
+    return status;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that finds the glyph table entry of a character.
+ * 
+ * @param[in] ch  character to look up
+ * @return index in the glyph tables or -1 when the character is not supported
+ ******************************************************************************
+ */
+static int8_t _i2c_lcd_bignum_index(uint8_t ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    switch (ch) {
+        case ':': return 10;
+        case '-': return 11;
+        case '.': return 12;
+        case ' ': return 13;
+        default:  return -1;
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_bignum.h
+ * @brief   Large numerals for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _I2C_LCD_BIGNUM_H_
+#define _I2C_LCD_BIGNUM_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+#define I2C_LCD_BIGNUM_LEFT     0
+#define I2C_LCD_BIGNUM_RIGHT    1
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * Area of the screen used by a large number. Digits are 3 cells wide and 2 or 4 rows
+ * high with I2C_LCD_BIGNUM_GAP blank columns between characters, a colon and a decimal
+ * point are 1 cell wide and a minus 2 cells.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint8_t col;                // left column of the area
+    uint8_t row;                // top row of the area
+    uint8_t width;              // columns, cells not used by the text are blanked
+    uint8_t height;             // 2 or 4 rows
+    uint8_t align;              // I2C_LCD_BIGNUM_LEFT or I2C_LCD_BIGNUM_RIGHT
+} i2c_lcd_bignum_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Uploads the 8 segment glyphs the large numerals are made of to CGRAM locations 0-7.
+ *
+ * Glyphs that are already resident are not written again so this costs nothing after
+ * the first call. Called by i2c_lcd_bignum_print, only needed to load the glyphs ahead
+ * of time.
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_bignum_load(void);
+
+ /**
+ ****************************************************************************************
+ * Prints text as large numerals.
+ *
+ * Supports 0-9, ':', '-', '.' and ' ' (blank digit), other characters are skipped and
+ * text that does not fit in the area is cut. The area is rendered in RAM and compared
+ * with what is on screen so only the cells of the digits that changed are written.
+ *
+ * @param[in] area   where to print
+ * @param[in] text   characters to print
+ * @param[in] length length of text
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_bignum_print(const i2c_lcd_bignum_t *area, const uint8_t *text, 
+    uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Returns the number of columns text takes as large numerals
+ *
+ * @param[in] text   characters to measure
+ * @param[in] length length of text
+ ****************************************************************************************
+ */
+uint8_t i2c_lcd_bignum_width(const uint8_t *text, uint8_t length);
+
+#endif // _I2C_LCD_BIGNUM_H_
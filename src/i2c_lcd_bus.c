@@ -0,0 +1,222 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_bus.c
+ *
+ * @brief Priorities and deferred transactions on an I2C controller shared by drivers.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include <stddef.h>
+#include "datasheet.h"
+#include "ll.h"
+#include "i2c.h"
+#include "i2c_lcd_bus.h"
+
+// Target address that is not a 7bit address, nothing is programmed
+#define BUS_NO_TARGET           0xFFFF
+
+i2c_lcd_bus_client_t *_bus_clients = NULL;          // registered, highest priority first
+i2c_lcd_bus_client_t * volatile _bus_holder = NULL; // background transfer on the bus
+volatile uint8_t _bus_pending = 0;                  // jobs posted and not run yet
+uint16_t _bus_target = BUS_NO_TARGET;               // address programmed in the controller
+bool _bus_in_job = false;                           // a job is running
+i2c_lcd_bus_clock_t _bus_clock = NULL;
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static uint32_t _i2c_lcd_bus_now(void);
+static void _i2c_lcd_bus_set_target(uint16_t address);
+static bool _i2c_lcd_bus_run_jobs(int16_t above);
+static void _i2c_lcd_bus_count_wait(i2c_lcd_bus_stats_t *stats, uint32_t us);
+
+/*-------------------------------------------------------------------------- */
+/* Bus API Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+void i2c_lcd_bus_register(i2c_lcd_bus_client_t *client) {
+    i2c_lcd_bus_client_t **link = &_bus_clients;
+    // Behind the clients of the same priority, they were there first
+    while (*link != NULL && (*link)->priority >= client->priority) {
+        link = &(*link)->next;
+    }
+    client->next = *link;
+    *link = client;
+}
+
+bool i2c_lcd_bus_post(i2c_lcd_bus_client_t *client, i2c_lcd_bus_job_t job, void *data) {
+    uint32_t now = _i2c_lcd_bus_now();
+    bool posted = false;
+    
+    GLOBAL_INT_DISABLE();
+    if (!client->pending) {
+        client->job = job;
+        client->job_data = data;
+        client->posted_us = now;
+        client->pending = true;
+        _bus_pending++;
+        posted = true;
+    }
+    GLOBAL_INT_RESTORE();
+    return posted;
+}
+
+void i2c_lcd_bus_select(i2c_lcd_bus_client_t *client) {
+    client->stats.selects++;
+    // Nothing to give way to, the common case on every character of the LCD
+    if (_bus_in_job || (_bus_holder == NULL && _bus_pending == 0)) {
+        _i2c_lcd_bus_set_target(client->address);
+        return;
+    }
+    
+    uint32_t start = _i2c_lcd_bus_now();
+    bool waited = _bus_holder != NULL;
+    while (_bus_holder != NULL);
+    if (_i2c_lcd_bus_run_jobs(client->priority)) {
+        waited = true;
+    }
+    if (waited) {
+        _i2c_lcd_bus_count_wait(&client->stats, _i2c_lcd_bus_now() - start);
+    }
+    _i2c_lcd_bus_set_target(client->address);
+}
+
+void i2c_lcd_bus_acquire(i2c_lcd_bus_client_t *client) {
+    i2c_lcd_bus_select(client);
+    _bus_holder = client;
+}
+
+void i2c_lcd_bus_release(i2c_lcd_bus_client_t *client) {
+    if (_bus_holder == client) {
+        _bus_holder = NULL;
+    }
+}
+
+void i2c_lcd_bus_run() {
+    if (_bus_holder == NULL && !_bus_in_job) {
+        _i2c_lcd_bus_run_jobs(-1);
+    }
+}
+
+void i2c_lcd_bus_reset() {
+    _bus_target = BUS_NO_TARGET;
+}
+
+void i2c_lcd_bus_set_clock(i2c_lcd_bus_clock_t clock) {
+    _bus_clock = clock;
+}
+
+void i2c_lcd_bus_get_stats(const i2c_lcd_bus_client_t *client, i2c_lcd_bus_stats_t *stats) {
+    *stats = client->stats;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+static uint32_t _i2c_lcd_bus_now() {
+    return _bus_clock != NULL ? _bus_clock() : 0;
+}
+
+/**
+ ******************************************************************************
+ * Private function that programs the target address. The controller has to 
+ * be disabled for it, which is skipped while the address is already set.
+ ******************************************************************************
+ */
+static void _i2c_lcd_bus_set_target(uint16_t address) {
+    if (address == _bus_target) {
+        return;
+    }
+    // Critical section
+    GLOBAL_INT_DISABLE();
+    i2c_set_controller_status(I2C_CONTROLLER_DISABLE);
+    i2c_set_target_address(address);
+    i2c_set_controller_status(I2C_CONTROLLER_ENABLE);
+    while (i2c_is_master_busy());               // Wait until no master activity
+    GLOBAL_INT_RESTORE();
+    _bus_target = address;
+}
+
+/**
+ ******************************************************************************
+ * Private function that runs the pending jobs of the clients with a priority 
+ * above [above], highest first. The list is searched again after every job 
+ * since a job of higher priority may have been posted meanwhile. Returns 
+ * true if a job ran.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_bus_run_jobs(int16_t above) {
+    bool ran = false;
+    
+    while (_bus_pending > 0) {
+        i2c_lcd_bus_client_t *client = _bus_clients;
+        while (client != NULL && !client->pending) {
+            client = client->next;
+        }
+        if (client == NULL || client->priority <= above) {
+            break;
+        }
+        
+        i2c_lcd_bus_job_t job;
+        void *data;
+        uint32_t posted;
+        GLOBAL_INT_DISABLE();
+        job = client->job;
+        data = client->job_data;
+        posted = client->posted_us;
+        // The client may post its next job while this one runs
+        client->pending = false;
+        _bus_pending--;
+        GLOBAL_INT_RESTORE();
+        
+        _i2c_lcd_bus_set_target(client->address);
+        // Only a job that ran later than it was posted waited, at the clock's 
+        // resolution
+        uint32_t waited_us = _i2c_lcd_bus_now() - posted;
+        if (waited_us > 0) {
+            _i2c_lcd_bus_count_wait(&client->stats, waited_us);
+        }
+        _bus_in_job = true;
+        job(data);
+        _bus_in_job = false;
+        // A job may have set the target without the manager (the SDK EEPROM 
+        // driver does), the next select programs it again
+        _bus_target = BUS_NO_TARGET;
+        client->stats.jobs++;
+        ran = true;
+    }
+    return ran;
+}
+
+static void _i2c_lcd_bus_count_wait(i2c_lcd_bus_stats_t *stats, uint32_t us) {
+    stats->waits++;
+    stats->wait_us += us;
+    if (us > stats->max_wait_us) {
+        stats->max_wait_us = us;
+    }
+}
@@ -0,0 +1,203 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_bus.h
+ * @brief   Shared I2C bus manager for the LCD and other drivers.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_BUS_H_
+#define _I2C_LCD_BUS_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * A transaction run by the bus manager once the bus is free for it, with the client's
+ * address already set as the target (see i2c_lcd_eeprom.h for the SDK EEPROM driver).
+ * The job may change the target, it is programmed again after the job.
+ ****************************************************************************************
+ */
+typedef void (*i2c_lcd_bus_job_t)(void *data);
+
+/**
+ ****************************************************************************************
+ * Free running microsecond clock for the wait statistics.
+ ****************************************************************************************
+ */
+typedef uint32_t (*i2c_lcd_bus_clock_t)(void);
+
+/**
+ ****************************************************************************************
+ * Per client counters. Wait times stay 0 until a clock is set with 
+ * i2c_lcd_bus_set_clock, a job counts as a wait only when the clock moved between 
+ * posting and running it.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint32_t selects;           // times the client was made the target
+    uint32_t jobs;              // deferred transactions run
+    uint32_t waits;             // selects that gave way and jobs run after a delay
+    uint32_t wait_us;           // total time spent waiting for the bus
+    uint32_t max_wait_us;       // longest single wait
+} i2c_lcd_bus_stats_t;
+
+/**
+ ****************************************************************************************
+ * A device (driver) on the shared controller. Set address and priority, leave the 
+ * rest zero: 
+ * 
+ *     i2c_lcd_bus_client_t sensor_bus = { .address = 0x48, .priority = 1 };
+ * 
+ * For an EEPROM use the wrapper in i2c_lcd_eeprom.h.
+ ****************************************************************************************
+ */
+typedef struct i2c_lcd_bus_client {
+    uint16_t address;           // 7bit target address
+    uint8_t  priority;          // a pending job runs before the transfers of any 
+                                // client with a lower priority
+    // Owned by the bus manager
+    struct i2c_lcd_bus_client *next;
+    i2c_lcd_bus_job_t job;
+    void *job_data;
+    volatile bool pending;
+    uint32_t posted_us;
+    i2c_lcd_bus_stats_t stats;
+} i2c_lcd_bus_client_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Adds a client that posts jobs to the manager. Call once from the main loop, before 
+ * the first i2c_lcd_bus_post. Clients that only select the bus need not register.
+ *
+ * @param[in] client client to add, it must stay valid
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_register(i2c_lcd_bus_client_t *client);
+
+ /**
+ ****************************************************************************************
+ * Queues a transaction for [client], safe from interrupt context. Nothing is sent 
+ * here: the job runs at the next character boundary of a lower priority client 
+ * (the LCD yields between characters), or from i2c_lcd_bus_run.
+ *
+ * @param[in] client registered client
+ * @param[in] job    transaction to run
+ * @param[in] data   passed to [job]
+ * @return false if the client already has a job pending
+ ****************************************************************************************
+ */
+bool i2c_lcd_bus_post(i2c_lcd_bus_client_t *client, i2c_lcd_bus_job_t job, void *data);
+
+ /**
+ ****************************************************************************************
+ * Makes [client] the target of the controller before its transfers. Call from the 
+ * main loop only. Waits for a transfer holding the bus (see i2c_lcd_bus_acquire) and 
+ * runs the pending jobs of higher priority clients first. A driver that keeps the 
+ * bus for a long update calls this again at every safe boundary so those jobs can 
+ * slip in.
+ *
+ * The target is only reprogrammed when it changes. Every driver on the controller 
+ * has to go through the manager, see i2c_lcd_bus_reset.
+ *
+ * @param[in] client client about to transfer
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_select(i2c_lcd_bus_client_t *client);
+
+ /**
+ ****************************************************************************************
+ * Selects [client] and holds the bus for it until i2c_lcd_bus_release, for 
+ * transfers that finish in the background (DMA). Call from the main loop only.
+ *
+ * @param[in] client client starting the transfer
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_acquire(i2c_lcd_bus_client_t *client);
+
+ /**
+ ****************************************************************************************
+ * Ends the hold taken with i2c_lcd_bus_acquire, safe from interrupt context (the 
+ * transfer complete callback). Pending jobs run at the next select or run.
+ *
+ * @param[in] client client holding the bus
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_release(i2c_lcd_bus_client_t *client);
+
+ /**
+ ****************************************************************************************
+ * Runs every pending job, highest priority first. Call from the main loop so jobs 
+ * also run while no other client is using the bus. Does nothing while the bus is 
+ * held.
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_run(void);
+
+ /**
+ ****************************************************************************************
+ * Forgets which target is programmed, call after i2c_init (which sets the target 
+ * from its config) or after a driver changed the target without the manager.
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_reset(void);
+
+ /**
+ ****************************************************************************************
+ * Sets the clock the wait times are measured with, NULL to stop measuring
+ *
+ * @param[in] clock microsecond clock
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_set_clock(i2c_lcd_bus_clock_t clock);
+
+ /**
+ ****************************************************************************************
+ * Copies the counters of a client
+ *
+ * @param[in]  client client to read
+ * @param[out] stats  destination for the counters
+ ****************************************************************************************
+ */
+void i2c_lcd_bus_get_stats(const i2c_lcd_bus_client_t *client, i2c_lcd_bus_stats_t *stats);
+
+#endif // _I2C_LCD_BUS_H_
@@ -0,0 +1,121 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_eeprom.c
+ *
+ * @brief I2C EEPROM reads and writes posted to the shared bus manager.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include "datasheet.h"
+#include "ll.h"
+#include "i2c_lcd_eeprom.h"
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static bool _i2c_lcd_eeprom_post(i2c_lcd_eeprom_t *eeprom, uint8_t *data, 
+    uint32_t address, uint32_t size, bool write);
+static void _i2c_lcd_eeprom_job(void *data);
+
+/*-------------------------------------------------------------------------- */
+/* EEPROM API Functions                                                      */ 
+/*---------------------------------------------------------------------------*/
+
+void i2c_lcd_eeprom_register(i2c_lcd_eeprom_t *eeprom) {
+    i2c_lcd_bus_register(&eeprom->bus);
+}
+
+bool i2c_lcd_eeprom_write(i2c_lcd_eeprom_t *eeprom, const uint8_t *data, 
+    uint32_t address, uint32_t size) {
+    // The SDK takes a non const pointer, the data is only read
+    return _i2c_lcd_eeprom_post(eeprom, (uint8_t *)data, address, size, true);
+}
+
+bool i2c_lcd_eeprom_read(i2c_lcd_eeprom_t *eeprom, uint8_t *data, uint32_t address, 
+    uint32_t size) {
+    return _i2c_lcd_eeprom_post(eeprom, data, address, size, false);
+}
+
+bool i2c_lcd_eeprom_busy(const i2c_lcd_eeprom_t *eeprom) {
+    return eeprom->busy;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that claims the request slot and posts the job. The slot 
+ * is claimed with interrupts disabled so two contexts cannot both fill it.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_eeprom_post(i2c_lcd_eeprom_t *eeprom, uint8_t *data, 
+    uint32_t address, uint32_t size, bool write) {
+    bool claimed = false;
+    
+    GLOBAL_INT_DISABLE();
+    if (!eeprom->busy) {
+        eeprom->busy = true;
+        claimed = true;
+    }
+    GLOBAL_INT_RESTORE();
+    if (!claimed) {
+        return false;
+    }
+    
+    eeprom->data = data;
+    eeprom->address = address;
+    eeprom->size = size;
+    eeprom->write = write;
+    if (!i2c_lcd_bus_post(&eeprom->bus, _i2c_lcd_eeprom_job, eeprom)) {
+        eeprom->busy = false;
+        return false;
+    }
+    return true;
+}
+
+/**
+ ******************************************************************************
+ * Private function run by the bus manager with the EEPROM address set as the 
+ * target. The SDK driver may set the target itself (the high address bits 
+ * of the small devices are in it), the manager forgets the target after 
+ * every job.
+ ******************************************************************************
+ */
+static void _i2c_lcd_eeprom_job(void *data) {
+    i2c_lcd_eeprom_t *eeprom = data;
+    eeprom->done = 0;
+    if (eeprom->write) {
+        eeprom->status = i2c_eeprom_write_data(eeprom->data, eeprom->address, 
+            eeprom->size, &eeprom->done);
+    } else {
+        eeprom->status = i2c_eeprom_read_data(eeprom->data, eeprom->address, 
+            eeprom->size, &eeprom->done);
+    }
+    eeprom->busy = false;
+}
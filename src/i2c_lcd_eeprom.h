@@ -0,0 +1,123 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_eeprom.h
+ * @brief   SDK I2C EEPROM transfers run as jobs on the shared bus.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_EEPROM_H_
+#define _I2C_LCD_EEPROM_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_eeprom.h"
+#include "i2c_lcd_bus.h"
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * An I2C EEPROM on the shared bus, driven by the SDK i2c_eeprom driver. Set the bus 
+ * address and priority, leave the rest zero:
+ * 
+ *     i2c_lcd_eeprom_t eeprom = { .bus = { .address = 0x50, .priority = 2 } };
+ ****************************************************************************************
+ */
+typedef struct {
+    i2c_lcd_bus_client_t bus;   // the EEPROM on the shared bus
+    // Last request, owned by the driver
+    uint8_t *data;
+    uint32_t address;
+    uint32_t size;
+    bool     write;
+    volatile bool busy;         // posted and not finished
+    i2c_error_code status;      // result of the last request
+    uint32_t done;              // bytes the last request read or wrote
+} i2c_lcd_eeprom_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Registers the EEPROM with the bus manager. Call once from the main loop, after
+ * i2c_eeprom_configure.
+ *
+ * @param[in] eeprom EEPROM to add, it must stay valid
+ ****************************************************************************************
+ */
+void i2c_lcd_eeprom_register(i2c_lcd_eeprom_t *eeprom);
+
+ /**
+ ****************************************************************************************
+ * Posts a write of [size] bytes at [address], safe from interrupt context. The write
+ * runs as a bus job (see i2c_lcd_bus_post) through i2c_eeprom_write_data, so it can go
+ * between two characters of an LCD update of lower priority. [data] must stay valid
+ * until i2c_lcd_eeprom_busy returns false.
+ *
+ * @param[in] eeprom  registered EEPROM
+ * @param[in] data    bytes to write
+ * @param[in] address EEPROM memory address
+ * @param[in] size    number of bytes
+ * @return false if the previous request has not finished
+ ****************************************************************************************
+ */
+bool i2c_lcd_eeprom_write(i2c_lcd_eeprom_t *eeprom, const uint8_t *data, 
+    uint32_t address, uint32_t size);
+
+ /**
+ ****************************************************************************************
+ * Posts a read of [size] bytes from [address] into [data], like i2c_lcd_eeprom_write.
+ *
+ * @param[in]  eeprom  registered EEPROM
+ * @param[out] data    destination, filled when the job has run
+ * @param[in]  address EEPROM memory address
+ * @param[in]  size    number of bytes
+ * @return false if the previous request has not finished
+ ****************************************************************************************
+ */
+bool i2c_lcd_eeprom_read(i2c_lcd_eeprom_t *eeprom, uint8_t *data, uint32_t address, 
+    uint32_t size);
+
+ /**
+ ****************************************************************************************
+ * Returns true until the last request has run, its result is then in status and done
+ ****************************************************************************************
+ */
+bool i2c_lcd_eeprom_busy(const i2c_lcd_eeprom_t *eeprom);
+
+#endif // _I2C_LCD_EEPROM_H_
@@ -0,0 +1,172 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_layout.c
+ *
+ * @brief Labels drawn once and fields redrawn only where their value changed.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include "i2c_lcd.h"
+#include "i2c_lcd_layout.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+// Shown in every cell of a field whose value does not fit
+#ifndef I2C_LCD_FIELD_OVERFLOW
+#define I2C_LCD_FIELD_OVERFLOW  '*'
+#endif
+
+#define FIELD_MAX_WIDTH     LCD_LINE_SIZE
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static i2c_lcd_status_t _i2c_lcd_layout_field(i2c_lcd_field_t *field);
+static uint8_t _i2c_lcd_layout_number(int32_t value, uint8_t decimals, uint8_t *text);
+
+/*-------------------------------------------------------------------------- */
+/* Layout API Functions                                                      */ 
+/*---------------------------------------------------------------------------*/
+
+i2c_lcd_status_t i2c_lcd_layout_draw(i2c_lcd_layout_t *layout) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    for (uint8_t i = 0; i < layout->num_fields && status == I2C_LCD_OK; i++) {
+        layout->fields[i].drawn = false;
+        status = _i2c_lcd_layout_field(&layout->fields[i]);
+    }
+    return status;
+}
+
+i2c_lcd_status_t i2c_lcd_layout_refresh(i2c_lcd_layout_t *layout) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    for (uint8_t i = 0; i < layout->num_fields && status == I2C_LCD_OK; i++) {
+        i2c_lcd_field_t *field = &layout->fields[i];
+        if (field->type == I2C_LCD_FIELD_LABEL) {
+            continue;
+        }
+        if (field->drawn && field->shown == *field->value) {
+            continue;
+        }
+        status = _i2c_lcd_layout_field(field);
+    }
+    return status;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that renders a label or field into its cells and hands 
+ * them to i2c_lcd_update, which sends only the cells that changed.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_layout_field(i2c_lcd_field_t *field) {
+    uint8_t text[FIELD_MAX_WIDTH];
+    uint8_t cells[FIELD_MAX_WIDTH];
+    uint8_t length = 0;
+    int32_t value = field->type == I2C_LCD_FIELD_LABEL ? 0 : *field->value;
+    
+    if (field->type == I2C_LCD_FIELD_INT) {
+        length = _i2c_lcd_layout_number(value, 0, text);
+    } else if (field->type == I2C_LCD_FIELD_FIXED) {
+        length = _i2c_lcd_layout_number(value, field->decimals, text);
+    } else {
+        const char *source = field->text;
+        if (field->type == I2C_LCD_FIELD_ENUM) {
+            source = value >= 0 && value < field->num_names ? field->names[value] : "?";
+        }
+        while (source[length] != '\0' && length < FIELD_MAX_WIDTH) {
+            text[length] = source[length];
+            length++;
+        }
+    }
+    
+    uint8_t width = field->width;
+    if (width == 0 || width > FIELD_MAX_WIDTH) {
+        width = field->width == 0 ? length : FIELD_MAX_WIDTH;
+    }
+    if (length > width && field->type != I2C_LCD_FIELD_LABEL && 
+        field->type != I2C_LCD_FIELD_ENUM) {
+        // A number that is cut would show a wrong value
+        for (uint8_t i = 0; i < width; i++) {
+            cells[i] = I2C_LCD_FIELD_OVERFLOW;
+        }
+    } else {
+        if (length > width) {
+            length = width;
+        }
+        uint8_t pad = width - length;
+        uint8_t start = field->align == I2C_LCD_ALIGN_RIGHT ? pad : 0;
+        for (uint8_t i = 0; i < width; i++) {
+            cells[i] = i >= start && i < start + length ? text[i - start] : ' ';
+        }
+    }
+    
+    i2c_lcd_status_t status = i2c_lcd_update(field->col, field->row, cells, width);
+    if (status == I2C_LCD_OK) {
+        field->shown = value;
+        field->drawn = true;
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Private function that writes [value] / 10^[decimals] in decimal, with a 
+ * leading minus sign when negative and a leading zero before the point. 
+ * Returns the number of characters.
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_layout_number(int32_t value, uint8_t decimals, uint8_t *text) {
+    uint8_t digits[12];
+    uint8_t count = 0;
+    uint8_t length = 0;
+    // Work on the magnitude as unsigned so INT32_MIN does not overflow
+    uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while ((magnitude > 0 || count <= decimals) && count < sizeof(digits));
+    
+    if (value < 0) {
+        text[length++] = '-';
+    }
+    while (count > 0) {
+        if (count == decimals && decimals > 0) {
+            text[length++] = '.';
+        }
+        text[length++] = digits[--count];
+    }
+    return length;
+}
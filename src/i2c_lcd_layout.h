@@ -0,0 +1,124 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_layout.h
+ * @brief   Screen layouts of labels and value bound fields for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_LAYOUT_H_
+#define _I2C_LCD_LAYOUT_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+#define I2C_LCD_FIELD_LABEL     0   // static text
+#define I2C_LCD_FIELD_INT       1   // integer
+#define I2C_LCD_FIELD_FIXED     2   // fixed point, value / 10^decimals
+#define I2C_LCD_FIELD_ENUM      3   // one of the names, selected by value
+
+#define I2C_LCD_ALIGN_LEFT      0
+#define I2C_LCD_ALIGN_RIGHT     1
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * One label or field of a layout. Fields are bound to a variable that is read when the
+ * layout is refreshed, the rendering is padded with spaces (or cut) to width cells.
+ * [shown] and [drawn] are kept by the layout functions, start them at zero.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint8_t type;                   // I2C_LCD_FIELD_LABEL, _INT, _FIXED or _ENUM
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;                  // cells, 0 for a label uses the length of text
+    uint8_t align;                  // I2C_LCD_ALIGN_LEFT or I2C_LCD_ALIGN_RIGHT
+    uint8_t decimals;               // digits after the point of a fixed point field
+    const char *text;               // label text
+    const char * const *names;      // enum field texts
+    uint8_t num_names;
+    const int32_t *value;           // bound variable
+    int32_t shown;                  // value on screen
+    bool drawn;                     // false until the field is on screen
+} i2c_lcd_field_t;
+
+/**
+ ****************************************************************************************
+ * A screen made of labels and fields
+ ****************************************************************************************
+ */
+typedef struct {
+    i2c_lcd_field_t *fields;
+    uint8_t num_fields;
+} i2c_lcd_layout_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Draws every label and field of a layout.
+ *
+ * Call it when the layout is put on screen. Only cells that differ from what the LCD
+ * shows are written (see i2c_lcd_update), so drawing over a similar screen is cheap.
+ *
+ * @param[in] layout layout to draw
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_layout_draw(i2c_lcd_layout_t *layout);
+
+ /**
+ ****************************************************************************************
+ * Redraws the fields whose bound variable changed since they were drawn.
+ *
+ * Labels are not touched. A field that changed is rendered again and only the cells
+ * that differ from the previous rendering are written, e.g. 23.4 to 23.5 sends one
+ * character.
+ *
+ * @param[in] layout layout to refresh
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_layout_refresh(i2c_lcd_layout_t *layout);
+
+#endif // _I2C_LCD_LAYOUT_H_
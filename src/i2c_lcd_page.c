@@ -0,0 +1,118 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_page.c
+ *
+ * @brief Pages composed ahead of time and switched by writing only what differs.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include <stddef.h>
+#include "i2c_lcd.h"
+#include "i2c_lcd_page.h"
+
+/*-------------------------------------------------------------------------- */
+/* Page API Functions                                                        */ 
+/*---------------------------------------------------------------------------*/
+
+void i2c_lcd_page_clear(i2c_lcd_page_t *page) {
+    for (uint8_t row = 0; row < I2C_LCD_PAGE_ROWS; row++) {
+        for (uint8_t col = 0; col < I2C_LCD_PAGE_COLS; col++) {
+            page->cells[row][col] = ' ';
+        }
+    }
+    page->glyph_mask = 0;
+}
+
+void i2c_lcd_page_print(i2c_lcd_page_t *page, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length) {
+    if (row >= I2C_LCD_PAGE_ROWS) {
+        return;
+    }
+    for (uint8_t i = 0; i < length && col + i < I2C_LCD_PAGE_COLS; i++) {
+        page->cells[row][col + i] = data[i];
+    }
+}
+
+void i2c_lcd_page_glyph(i2c_lcd_page_t *page, uint8_t location, const uint8_t *charmap) {
+    location &= 0x07;
+    for (uint8_t i = 0; i < 8; i++) {
+        page->glyphs[location][i] = charmap[i];
+    }
+    page->glyph_mask |= 1 << location;
+}
+
+/**
+ ******************************************************************************
+ * A glyph that changes while the outgoing page still shows its location would
+ * show up in the old cells until they are rewritten. In that case the rows go
+ * first with every cell of a changing location blanked, which takes all the 
+ * old uses off the screen. Then the glyphs are uploaded and the rows written 
+ * for real, so no cell ever shows a wrong glyph. create_char and 
+ * i2c_lcd_update compare with the driver's RAM copy, so the switch only costs
+ * the difference between the two pages.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_page_show(const i2c_lcd_page_t *page, uint32_t *bytes) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    i2c_lcd_stats_t before;
+    i2c_lcd_stats_t after;
+    uint8_t changing = 0;
+    bool on_screen = false;
+    i2c_lcd_get_stats(&before);
+    
+    for (uint8_t location = 0; location < 8; location++) {
+        if ((page->glyph_mask & (1 << location)) && 
+            !i2c_lcd_char_matches(location, page->glyphs[location])) {
+            changing |= 1 << location;
+            on_screen = on_screen || i2c_lcd_char_on_screen(location);
+        }
+    }
+    if (on_screen) {
+        for (uint8_t row = 0; row < I2C_LCD_PAGE_ROWS && status == I2C_LCD_OK; row++) {
+            uint8_t blanked[I2C_LCD_PAGE_COLS];
+            for (uint8_t col = 0; col < I2C_LCD_PAGE_COLS; col++) {
+                uint8_t cell = page->cells[row][col];
+                blanked[col] = (cell < 0x10 && (changing & (1 << (cell & 0x07)))) ? ' ' : cell;
+            }
+            status = i2c_lcd_update(0, row, blanked, I2C_LCD_PAGE_COLS);
+        }
+    }
+    for (uint8_t location = 0; location < 8 && status == I2C_LCD_OK; location++) {
+        if (page->glyph_mask & (1 << location)) {
+            status = i2c_lcd_create_char(location, page->glyphs[location]);
+        }
+    }
+    for (uint8_t row = 0; row < I2C_LCD_PAGE_ROWS && status == I2C_LCD_OK; row++) {
+        status = i2c_lcd_update(0, row, page->cells[row], I2C_LCD_PAGE_COLS);
+    }
+    
+    if (bytes != NULL) {
+        i2c_lcd_get_stats(&after);
+        *bytes = after.bus_bytes - before.bus_bytes;
+    }
+    return status;
+}
@@ -0,0 +1,139 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_page.h
+ * @brief   Screen pages composed in RAM for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_PAGE_H_
+#define _I2C_LCD_PAGE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+
+// Size of a page, the visible part of the screen
+#ifndef I2C_LCD_PAGE_COLS
+#ifdef I2C_LCD_NUM_COLS
+#define I2C_LCD_PAGE_COLS   I2C_LCD_NUM_COLS
+#else
+#define I2C_LCD_PAGE_COLS   16
+#endif
+#endif
+
+#ifndef I2C_LCD_PAGE_ROWS
+#ifdef I2C_LCD_NUM_ROWS
+#define I2C_LCD_PAGE_ROWS   I2C_LCD_NUM_ROWS
+#else
+#define I2C_LCD_PAGE_ROWS   2
+#endif
+#endif
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * A screen composed in RAM: the text and the custom characters it needs.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint8_t cells[I2C_LCD_PAGE_ROWS][I2C_LCD_PAGE_COLS];
+    uint8_t glyphs[8][8];           // custom characters, by CGRAM location
+    uint8_t glyph_mask;             // bit per location the page sets
+} i2c_lcd_page_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Empties a page: all spaces and no custom characters
+ *
+ * @param[out] page page to empty
+ ****************************************************************************************
+ */
+void i2c_lcd_page_clear(i2c_lcd_page_t *page);
+
+ /**
+ ****************************************************************************************
+ * Puts an array of chars on a page, text past the end of the row is dropped. Nothing is
+ * sent to the LCD.
+ *
+ * @param[in,out] page   page to write
+ * @param[in]     col    column number, zero indexed
+ * @param[in]     row    row number, zero indexed
+ * @param[in]     data   Character data pointer
+ * @param[in]     length length of data
+ ****************************************************************************************
+ */
+void i2c_lcd_page_print(i2c_lcd_page_t *page, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Gives a page a custom character, it is uploaded when the page is shown
+ *
+ * @param[in,out] page     page to write
+ * @param[in]     location CGRAM location 0-7
+ * @param[in]     charmap  8 rows of 5 pixels
+ ****************************************************************************************
+ */
+void i2c_lcd_page_glyph(i2c_lcd_page_t *page, uint8_t location, const uint8_t *charmap);
+
+ /**
+ ****************************************************************************************
+ * Puts a page on the LCD without clearing it.
+ *
+ * The custom characters of the page are uploaded, only the glyph rows that differ from
+ * CGRAM are written. Each row of the page is compared with what the LCD shows and only
+ * the cells that differ are written (see i2c_lcd_update), so switching between pages
+ * that share a layout costs little more than the changed text. When a glyph changes
+ * while the LCD still shows it, the cells are written first with that glyph blanked,
+ * so no cell ever shows the wrong bitmap.
+ *
+ * @param[in]  page  page to show
+ * @param[out] bytes expander bytes the switch put on the bus, may be NULL
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_page_show(const i2c_lcd_page_t *page, uint32_t *bytes);
+
+#endif // _I2C_LCD_PAGE_H_
@@ -0,0 +1,265 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_queue.c
+ *
+ * @brief Lock-free queue of display updates posted from interrupt context.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include "datasheet.h"
+#include "ll.h"
+#include "i2c_lcd.h"
+#include "i2c_lcd_queue.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+// Number of updates the queue holds, must be a power of 2 (up to 128)
+#ifndef I2C_LCD_QUEUE_SIZE
+#define I2C_LCD_QUEUE_SIZE      8
+#endif
+
+// Longest text in one update
+#ifndef I2C_LCD_QUEUE_TEXT
+#define I2C_LCD_QUEUE_TEXT      16
+#endif
+
+#ifndef I2C_LCD_QUEUE_OVERFLOW
+#define I2C_LCD_QUEUE_OVERFLOW  I2C_LCD_QUEUE_DROP_NEW
+#endif
+
+#define QUEUE_MASK              (I2C_LCD_QUEUE_SIZE - 1)
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+    uint8_t length;
+    uint8_t data[I2C_LCD_QUEUE_TEXT];
+} i2c_lcd_queue_item_t;
+
+/**
+ ******************************************************************************
+ * The ring is indexed with free running 8 bit counters: producers own _head, 
+ * the consumer owns _tail and head - tail is the number of slots in use. A 
+ * slot is only read once its _ready flag is set, so a multi-producer post 
+ * that has claimed a slot but not finished copying holds the consumer back.
+ ******************************************************************************
+ */
+i2c_lcd_queue_item_t _queue[I2C_LCD_QUEUE_SIZE];
+volatile uint8_t _queue_ready[I2C_LCD_QUEUE_SIZE];
+volatile uint8_t _queue_head = 0;
+volatile uint8_t _queue_tail = 0;
+i2c_lcd_queue_stats_t _queue_stats;
+
+#if I2C_LCD_QUEUE_OVERFLOW == I2C_LCD_QUEUE_KEEP_LATEST
+// Newest update that did not fit, guarded by a sequence count (odd while written). 
+// It goes on screen after the ring posts before _queue_latest_head.
+i2c_lcd_queue_item_t _queue_latest;
+uint8_t _queue_latest_head;
+volatile uint32_t _queue_latest_seq = 0;
+uint32_t _queue_latest_taken = 0;
+#endif
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static void _i2c_lcd_queue_fill(i2c_lcd_queue_item_t *item, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length);
+static bool _i2c_lcd_queue_overflow(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length);
+#if I2C_LCD_QUEUE_OVERFLOW == I2C_LCD_QUEUE_KEEP_LATEST
+static bool _i2c_lcd_queue_take_latest(uint8_t tail, i2c_lcd_queue_item_t *item);
+#endif
+
+/*-------------------------------------------------------------------------- */
+/* Queue API Functions                                                       */ 
+/*---------------------------------------------------------------------------*/
+
+bool i2c_lcd_queue_post(uint8_t col, uint8_t row, const uint8_t *data, uint8_t length) {
+    uint8_t head = _queue_head;
+    uint8_t used = head - _queue_tail;
+    if (used >= I2C_LCD_QUEUE_SIZE) {
+        return _i2c_lcd_queue_overflow(col, row, data, length);
+    }
+    _i2c_lcd_queue_fill(&_queue[head & QUEUE_MASK], col, row, data, length);
+    // The item must be complete before the consumer can see it
+    __DMB();
+    _queue_ready[head & QUEUE_MASK] = 1;
+    __DMB();
+    _queue_head = head + 1;
+    
+    _queue_stats.posted++;
+    if (used + 1 > _queue_stats.high_water) {
+        _queue_stats.high_water = used + 1;
+    }
+    return true;
+}
+
+bool i2c_lcd_queue_post_mp(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length) {
+    uint8_t head;
+    bool full;
+    
+    // Claim a slot, this is the only part that needs interrupts disabled
+    GLOBAL_INT_DISABLE();
+    head = _queue_head;
+    uint8_t used = head - _queue_tail;
+    full = used >= I2C_LCD_QUEUE_SIZE;
+    if (!full) {
+        _queue_head = head + 1;
+        _queue_stats.posted++;
+        if (used + 1 > _queue_stats.high_water) {
+            _queue_stats.high_water = used + 1;
+        }
+    }
+    GLOBAL_INT_RESTORE();
+    
+    if (full) {
+        bool kept;
+        GLOBAL_INT_DISABLE();
+        kept = _i2c_lcd_queue_overflow(col, row, data, length);
+        GLOBAL_INT_RESTORE();
+        return kept;
+    }
+    _i2c_lcd_queue_fill(&_queue[head & QUEUE_MASK], col, row, data, length);
+    __DMB();
+    _queue_ready[head & QUEUE_MASK] = 1;
+    return true;
+}
+
+i2c_lcd_status_t i2c_lcd_queue_drain(uint8_t max) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    i2c_lcd_queue_item_t item;
+    uint8_t count = 0;
+    
+    while ((max == 0 || count < max) && status == I2C_LCD_OK) {
+        uint8_t tail = _queue_tail;
+        uint8_t index = tail & QUEUE_MASK;
+#if I2C_LCD_QUEUE_OVERFLOW == I2C_LCD_QUEUE_KEEP_LATEST
+        // The update kept aside goes before the ring posts made after it
+        if (_i2c_lcd_queue_take_latest(tail, &item)) {
+            status = i2c_lcd_update(item.col, item.row, item.data, item.length);
+            count++;
+            continue;
+        }
+#endif
+        if (tail == _queue_head || !_queue_ready[index]) {
+            break;
+        }
+        __DMB();
+        item = _queue[index];
+        // Give the slot back before the (slow) LCD write
+        _queue_ready[index] = 0;
+        __DMB();
+        _queue_tail = tail + 1;
+        status = i2c_lcd_update(item.col, item.row, item.data, item.length);
+        count++;
+    }
+    return status;
+}
+
+void i2c_lcd_queue_get_stats(i2c_lcd_queue_stats_t *stats) {
+    *stats = _queue_stats;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+static void _i2c_lcd_queue_fill(i2c_lcd_queue_item_t *item, uint8_t col, uint8_t row, 
+    const uint8_t *data, uint8_t length) {
+    if (length > I2C_LCD_QUEUE_TEXT) {
+        length = I2C_LCD_QUEUE_TEXT;
+    }
+    item->col = col;
+    item->row = row;
+    item->length = length;
+    for (uint8_t i = 0; i < length; i++) {
+        item->data[i] = data[i];
+    }
+}
+
+/**
+ ******************************************************************************
+ * Private function that applies the overflow policy to an update that did 
+ * not fit. With I2C_LCD_QUEUE_KEEP_LATEST the update replaces the one kept 
+ * aside (which is counted as dropped) together with the ring position it 
+ * was posted at; the sequence count is odd while the copy is made so the 
+ * consumer can tell it read a torn update and try again.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_queue_overflow(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length) {
+#if I2C_LCD_QUEUE_OVERFLOW == I2C_LCD_QUEUE_KEEP_LATEST
+    if (_queue_latest_seq != _queue_latest_taken) {
+        _queue_stats.dropped++;
+    }
+    _queue_latest_seq++;
+    __DMB();
+    _i2c_lcd_queue_fill(&_queue_latest, col, row, data, length);
+    _queue_latest_head = _queue_head;
+    __DMB();
+    _queue_latest_seq++;
+    return true;
+#else
+    _queue_stats.dropped++;
+    return false;
+#endif
+}
+
+#if I2C_LCD_QUEUE_OVERFLOW == I2C_LCD_QUEUE_KEEP_LATEST
+/**
+ ******************************************************************************
+ * Private function that copies the update kept aside into [item] once every 
+ * ring post older than it is on screen, i.e. the ring [tail] has reached 
+ * the head it was kept at. Returns false if there is none or it must wait.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_queue_take_latest(uint8_t tail, i2c_lcd_queue_item_t *item) {
+    uint32_t seq;
+    uint8_t head;
+    
+    if (_queue_latest_seq == _queue_latest_taken) {
+        return false;
+    }
+    do {
+        seq = _queue_latest_seq;
+        __DMB();
+        *item = _queue_latest;
+        head = _queue_latest_head;
+        __DMB();
+    } while ((seq & 1) || seq != _queue_latest_seq);
+    if ((int8_t)(tail - head) < 0) {
+        return false;
+    }
+    _queue_latest_taken = seq;
+    return true;
+}
+#endif
@@ -0,0 +1,131 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_queue.h
+ * @brief   Interrupt safe update queue for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_QUEUE_H_
+#define _I2C_LCD_QUEUE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+// What happens to a post when the queue is full, set I2C_LCD_QUEUE_OVERFLOW to one of these
+#define I2C_LCD_QUEUE_DROP_NEW      0   // the new update is dropped
+#define I2C_LCD_QUEUE_KEEP_LATEST   1   // the newest update is kept aside, the ones
+                                        // before it (since the queue filled) are dropped
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * Queue counters, updated by the producers.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint32_t posted;            // updates queued
+    uint32_t dropped;           // updates lost because the queue was full
+    uint8_t  high_water;        // most updates waiting at once
+} i2c_lcd_queue_stats_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Posts text for col and row from a single producer (one interrupt handler, or the
+ * main loop only).
+ *
+ * Lock-free and bounded: copies at most I2C_LCD_QUEUE_TEXT (16) chars and never waits,
+ * interrupts stay enabled. Nothing is sent on the bus, see i2c_lcd_queue_drain. Text
+ * longer than I2C_LCD_QUEUE_TEXT is cut.
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ * @return false if the update was dropped (queue full)
+ ****************************************************************************************
+ */
+bool i2c_lcd_queue_post(uint8_t col, uint8_t row, const uint8_t *data, uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Posts text for col and row, safe from any number of interrupt handlers and the main
+ * loop.
+ *
+ * The Cortex-M0+ has no exclusive load/store, so the slot is claimed with interrupts
+ * disabled for a few instructions; the text is copied with interrupts enabled. Do not
+ * mix with i2c_lcd_queue_post.
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] data   Character data pointer
+ * @param[in] length length of data
+ * @return false if the update was dropped (queue full)
+ ****************************************************************************************
+ */
+bool i2c_lcd_queue_post_mp(uint8_t col, uint8_t row, const uint8_t *data, 
+    uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Writes queued updates to the LCD, oldest first. Call from the main loop only, the
+ * updates go through i2c_lcd_update so unchanged cells are not sent.
+ *
+ * @param[in] max most updates to write in this call, 0 for all
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_queue_drain(uint8_t max);
+
+ /**
+ ****************************************************************************************
+ * Copies the queue counters
+ *
+ * @param[out] stats destination for the counters
+ ****************************************************************************************
+ */
+void i2c_lcd_queue_get_stats(i2c_lcd_queue_stats_t *stats);
+
+#endif // _I2C_LCD_QUEUE_H_
@@ -0,0 +1,247 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_scroll.c
+ *
+ * @brief Pixel smooth scrolling of a text window through CGRAM.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include "i2c_lcd.h"
+#include "i2c_lcd_scroll.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+#define FONT_FIRST          0x20 // first character in the font table
+#define FONT_LAST           0x7E
+#define FONT_WIDTH          5
+#define CHAR_PITCH          6    // font columns plus one blank column
+
+/**
+ ******************************************************************************
+ * 5x7 font, printable ASCII. One byte per column, left to right, bit 0 is the 
+ * top row.
+ ******************************************************************************
+ */
+static const uint8_t _font[FONT_LAST - FONT_FIRST + 1][FONT_WIDTH] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, // "
+    { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // #
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, // $
+    { 0x23, 0x13, 0x08, 0x64, 0x62 }, // %
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, // &
+    { 0x00, 0x05, 0x03, 0x00, 0x00 }, // '
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, // (
+    { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // )
+    { 0x14, 0x08, 0x3E, 0x08, 0x14 }, // *
+    { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, // ,
+    { 0x08, 0x08, 0x08, 0x08, 0x08 }, // -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, // .
+    { 0x20, 0x10, 0x08, 0x04, 0x02 }, // /
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, // 0
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, // 2
+    { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, // 4
+    { 0x27, 0x45, 0x45, 0x45, 0x39 }, // 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, // 6
+    { 0x01, 0x71, 0x09, 0x05, 0x03 }, // 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, // 8
+    { 0x06, 0x49, 0x49, 0x29, 0x1E }, // 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, // :
+    { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, // <
+    { 0x14, 0x14, 0x14, 0x14, 0x14 }, // =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, // >
+    { 0x02, 0x01, 0x51, 0x09, 0x06 }, // ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, // @
+    { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // A
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, // B
+    { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // C
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, // D
+    { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // E
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, // F
+    { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // G
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, // H
+    { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // I
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, // J
+    { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // K
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, // L
+    { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // M
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, // N
+    { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // O
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, // P
+    { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // Q
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, // R
+    { 0x46, 0x49, 0x49, 0x49, 0x31 }, // S
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, // T
+    { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // U
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, // V
+    { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, // X
+    { 0x07, 0x08, 0x70, 0x08, 0x07 }, // Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, // Z
+    { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, // backslash
+    { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, // ^
+    { 0x40, 0x40, 0x40, 0x40, 0x40 }, // _
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, // `
+    { 0x20, 0x54, 0x54, 0x54, 0x78 }, // a
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, // b
+    { 0x38, 0x44, 0x44, 0x44, 0x20 }, // c
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, // d
+    { 0x38, 0x54, 0x54, 0x54, 0x18 }, // e
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, // f
+    { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // g
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, // h
+    { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // i
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, // j
+    { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // k
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, // l
+    { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // m
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, // n
+    { 0x38, 0x44, 0x44, 0x44, 0x38 }, // o
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, // p
+    { 0x08, 0x14, 0x14, 0x18, 0x7C }, // q
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, // r
+    { 0x48, 0x54, 0x54, 0x54, 0x20 }, // s
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, // t
+    { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // u
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, // v
+    { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // w
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, // x
+    { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // y
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, // z
+    { 0x00, 0x08, 0x36, 0x41, 0x00 }, // {
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, // |
+    { 0x00, 0x41, 0x36, 0x08, 0x00 }, // }
+    { 0x08, 0x04, 0x08, 0x10, 0x08 }, // ~
+};
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static uint8_t _i2c_lcd_scroll_column(const i2c_lcd_scroll_t *scroll);
+static i2c_lcd_status_t _i2c_lcd_scroll_upload(const i2c_lcd_scroll_t *scroll);
+
+/*-------------------------------------------------------------------------- */
+/* Smooth Scroll API Functions                                               */ 
+/*---------------------------------------------------------------------------*/
+
+i2c_lcd_status_t i2c_lcd_scroll_start(i2c_lcd_scroll_t *scroll, const uint8_t *text, 
+    uint8_t length) {
+    uint8_t cells[I2C_LCD_SCROLL_MAX_CELLS];
+    
+    if (scroll->width > I2C_LCD_SCROLL_MAX_CELLS) {
+        scroll->width = I2C_LCD_SCROLL_MAX_CELLS;
+    }
+    scroll->text = text;
+    scroll->length = length;
+    scroll->position = 0;
+    for (uint8_t row = 0; row < 8; row++) {
+        scroll->rows[row] = 0;
+    }
+    
+    i2c_lcd_status_t status = _i2c_lcd_scroll_upload(scroll);
+    if (status != I2C_LCD_OK) {
+        return status;
+    }
+    for (uint8_t i = 0; i < scroll->width; i++) {
+        cells[i] = (scroll->base + i) & 0x07;
+    }
+    return i2c_lcd_update(scroll->col, scroll->row, cells, scroll->width);
+}
+
+/**
+ ******************************************************************************
+ * The window is kept as one 64 bit word per glyph row holding the pixels of 
+ * all its cells side by side, the leftmost pixel in the highest bit. A step 
+ * shifts every row word left by one and brings in the next text column, each 
+ * cell's glyph row is then a 5 bit field of the row word.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_scroll_step(i2c_lcd_scroll_t *scroll) {
+    uint8_t column = _i2c_lcd_scroll_column(scroll);
+    for (uint8_t row = 0; row < 7; row++) {
+        scroll->rows[row] = (scroll->rows[row] << 1) | ((column >> row) & 0x01);
+    }
+    
+    // The text scrolls out completely before it starts again
+    uint16_t total = scroll->length * CHAR_PITCH + scroll->width * FONT_WIDTH;
+    if (++scroll->position >= total) {
+        scroll->position = 0;
+    }
+    return _i2c_lcd_scroll_upload(scroll);
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that returns the pixel column of the text at the scroll 
+ * position, blank after the end of the text.
+ ******************************************************************************
+ */
+static uint8_t _i2c_lcd_scroll_column(const i2c_lcd_scroll_t *scroll) {
+    uint16_t index = scroll->position / CHAR_PITCH;
+    uint8_t column = scroll->position % CHAR_PITCH;
+    if (index >= scroll->length || column >= FONT_WIDTH) {
+        return 0x00;
+    }
+    uint8_t ch = scroll->text[index];
+    if (ch < FONT_FIRST || ch > FONT_LAST) {
+        ch = ' ';
+    }
+    return _font[ch - FONT_FIRST][column];
+}
+
+/**
+ ******************************************************************************
+ * Private function that cuts the row words into glyphs and hands them to 
+ * create_char, which only writes the rows that differ from CGRAM.
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_scroll_upload(const i2c_lcd_scroll_t *scroll) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    for (uint8_t cell = 0; cell < scroll->width && status == I2C_LCD_OK; cell++) {
+        uint8_t charmap[8];
+        uint8_t shift = (scroll->width - 1 - cell) * FONT_WIDTH;
+        for (uint8_t row = 0; row < 8; row++) {
+            charmap[row] = (scroll->rows[row] >> shift) & 0x1F;
+        }
+        status = i2c_lcd_create_char(scroll->base + cell, charmap);
+    }
+    return status;
+}
@@ -0,0 +1,105 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_scroll.h
+ * @brief   Pixel smooth scrolling for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_SCROLL_H_
+#define _I2C_LCD_SCROLL_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+#define I2C_LCD_SCROLL_MAX_CELLS    8   // one CGRAM location per cell
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * A window of up to 8 cells that text scrolls through one pixel column at a time. The
+ * cells show CGRAM locations base to base + width - 1, the text is drawn into those
+ * glyphs with a 5x7 font. The application sets the first four fields, the rest belong
+ * to the scroller.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+    uint8_t width;              // cells, 1-8
+    uint8_t base;               // first CGRAM location, base + width must be 8 or less
+    const uint8_t *text;
+    uint8_t length;
+    uint16_t position;          // next pixel column of the text to shift in
+    uint64_t rows[8];           // pixels in the window, one word per glyph row
+} i2c_lcd_scroll_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Starts scrolling text through a window. The window is blanked and its cells are put
+ * on screen, the text enters from the right with i2c_lcd_scroll_step.
+ *
+ * @param[in] scroll window to use
+ * @param[in] text   characters to scroll (ASCII), must stay valid while scrolling
+ * @param[in] length length of text
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_scroll_start(i2c_lcd_scroll_t *scroll, const uint8_t *text, 
+    uint8_t length);
+
+ /**
+ ****************************************************************************************
+ * Scrolls the window one pixel to the left. Call it periodically, the text leaves the
+ * window on the left and starts again from the right.
+ *
+ * Only the glyph rows that changed are uploaded, a step costs at most 8 rows per cell
+ * and nothing for the rows that are blank or stay the same.
+ *
+ * @param[in] scroll window to scroll
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_scroll_step(i2c_lcd_scroll_t *scroll);
+
+#endif // _I2C_LCD_SCROLL_H_
@@ -0,0 +1,147 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_sprite.c
+ *
+ * @brief Sprite animation with delta CGRAM frame uploads.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include <stddef.h>
+#include "i2c_lcd.h"
+#include "i2c_lcd_sprite.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+#define SPRITE_MAX          8    // one per CGRAM location
+#define SPRITE_BACKGROUND   ' '  // character left in a cell a sprite moved out of
+
+// Private state variables
+i2c_lcd_sprite_t *_sprites[SPRITE_MAX];
+uint8_t _num_sprites = 0;
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static bool _i2c_lcd_sprite_covers(uint8_t col, uint8_t row);
+
+/*-------------------------------------------------------------------------- */
+/* Sprite API Functions                                                      */ 
+/*---------------------------------------------------------------------------*/
+
+bool i2c_lcd_sprite_add(i2c_lcd_sprite_t *sprite) {
+    if (_num_sprites >= SPRITE_MAX) {
+        return false;
+    }
+    sprite->drawn = false;
+    _sprites[_num_sprites++] = sprite;
+    return true;
+}
+
+void i2c_lcd_sprite_remove_all() {
+    _num_sprites = 0;
+}
+
+void i2c_lcd_sprite_move(i2c_lcd_sprite_t *sprite, uint8_t col, uint8_t row) {
+    sprite->col = col;
+    sprite->row = row;
+}
+
+/**
+ ******************************************************************************
+ * A frame is drawn in three passes: the glyph rows of every sprite (delta 
+ * uploads through create_char), the cells that were left and the cells that 
+ * are now taken. Cells are written with i2c_lcd_update so a sprite that is 
+ * already in place is not written again.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_sprite_tick(uint32_t *bytes) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    i2c_lcd_stats_t before;
+    i2c_lcd_stats_t after;
+    i2c_lcd_get_stats(&before);
+    
+    for (uint8_t i = 0; i < _num_sprites && status == I2C_LCD_OK; i++) {
+        i2c_lcd_sprite_t *sprite = _sprites[i];
+        if (sprite->frame >= sprite->num_frames) {
+            sprite->frame = 0;
+        }
+        status = i2c_lcd_create_char(sprite->location, sprite->frames[sprite->frame]);
+    }
+    
+    // Clear the cells that were left before anything is drawn over them
+    uint8_t background[1] = { SPRITE_BACKGROUND };
+    for (uint8_t i = 0; i < _num_sprites && status == I2C_LCD_OK; i++) {
+        i2c_lcd_sprite_t *sprite = _sprites[i];
+        if (sprite->drawn && 
+            !_i2c_lcd_sprite_covers(sprite->drawn_col, sprite->drawn_row)) {
+            status = i2c_lcd_update(sprite->drawn_col, sprite->drawn_row, 
+                background, 1);
+        }
+        sprite->drawn = false;
+    }
+    
+    for (uint8_t i = 0; i < _num_sprites && status == I2C_LCD_OK; i++) {
+        i2c_lcd_sprite_t *sprite = _sprites[i];
+        if (sprite->visible && sprite->col != I2C_LCD_SPRITE_UNPLACED) {
+            uint8_t cell[1] = { sprite->location & 0x07 };
+            status = i2c_lcd_update(sprite->col, sprite->row, cell, 1);
+            sprite->drawn_col = sprite->col;
+            sprite->drawn_row = sprite->row;
+            sprite->drawn = true;
+        }
+        sprite->frame++;
+    }
+    
+    if (bytes != NULL) {
+        i2c_lcd_get_stats(&after);
+        *bytes = after.bus_bytes - before.bus_bytes;
+    }
+    return status;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that tells if a visible sprite is about to be drawn in a 
+ * cell.
+ ******************************************************************************
+ */
+static bool _i2c_lcd_sprite_covers(uint8_t col, uint8_t row) {
+    for (uint8_t i = 0; i < _num_sprites; i++) {
+        if (_sprites[i]->visible && _sprites[i]->col == col && _sprites[i]->row == row) {
+            return true;
+        }
+    }
+    return false;
+}
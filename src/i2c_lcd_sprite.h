@@ -0,0 +1,128 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_sprite.h
+ * @brief   Sprite animation for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_SPRITE_H_
+#define _I2C_LCD_SPRITE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+// Column of a sprite that is animated but not placed on screen by the engine
+#define I2C_LCD_SPRITE_UNPLACED 0xFF
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * A sprite is an animated custom character. Each frame is a full 8 row bitmap, the
+ * frames are played one per i2c_lcd_sprite_tick. The application sets col, row and
+ * visible (or calls i2c_lcd_sprite_move), the drawn_ fields belong to the engine.
+ *
+ * An unplaced sprite (col I2C_LCD_SPRITE_UNPLACED) is only animated, the application
+ * can put its location on screen itself, as many times as it likes.
+ ****************************************************************************************
+ */
+typedef struct {
+    const uint8_t (*frames)[8]; // frame bitmaps
+    uint8_t num_frames;
+    uint8_t frame;              // frame shown by the next tick
+    uint8_t location;           // CGRAM location 0-7, one per sprite
+    uint8_t col;
+    uint8_t row;
+    bool    visible;
+    uint8_t drawn_col;          // cell the sprite was drawn in by the last tick
+    uint8_t drawn_row;
+    bool    drawn;
+} i2c_lcd_sprite_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Adds a sprite to the engine, up to 8 sprites (one per CGRAM location).
+ *
+ * @param[in] sprite sprite to add, must stay valid while it is in the engine
+ * @return false if the engine is full
+ ****************************************************************************************
+ */
+bool i2c_lcd_sprite_add(i2c_lcd_sprite_t *sprite);
+
+ /**
+ ****************************************************************************************
+ * Removes all sprites from the engine, the screen is not touched
+ ****************************************************************************************
+ */
+void i2c_lcd_sprite_remove_all(void);
+
+ /**
+ ****************************************************************************************
+ * Moves a sprite, it is redrawn by the next tick
+ *
+ * @param[in] sprite sprite to move
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ ****************************************************************************************
+ */
+void i2c_lcd_sprite_move(i2c_lcd_sprite_t *sprite, uint8_t col, uint8_t row);
+
+ /**
+ ****************************************************************************************
+ * Draws the next frame of every sprite. Call it from the main loop or a scheduled
+ * event, not from an interrupt: it blocks on the bus for the whole frame. A periodic
+ * timer ISR should only set a flag that the main loop polls.
+ *
+ * Only the CGRAM rows that differ from the previous frame are uploaded. A sprite that
+ * moved costs the cell it left (set to a space unless another sprite moved in) and the
+ * cell it moved to, a sprite that stayed in place costs nothing but its glyph rows.
+ *
+ * @param[out] bytes expander bytes this frame put on the bus, can be NULL
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_sprite_tick(uint32_t *bytes);
+
+#endif // _I2C_LCD_SPRITE_H_
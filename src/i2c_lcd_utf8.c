@@ -0,0 +1,325 @@
+/**
+ ********************************************************************************
+ *
+ * @file i2c_lcd_utf8.c
+ *
+ * @brief UTF-8 to HD44780 character ROM mapping with CGRAM fallback.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ********************************************************************************
+ */
+
+#include <stddef.h>
+#include "i2c_lcd.h"
+#include "i2c_lcd_utf8.h"
+
+/**
+ ****************************************************************************************
+ * DEFAULT CONFIG
+ ****************************************************************************************
+ */
+
+#ifndef I2C_LCD_ROM
+#define I2C_LCD_ROM             I2C_LCD_ROM_A00
+#endif
+
+// Printed for malformed UTF-8 and characters with no ROM code and no glyph
+#ifndef I2C_LCD_UTF8_UNKNOWN
+#define I2C_LCD_UTF8_UNKNOWN    '?'
+#endif
+
+// CGRAM locations used for the glyphs of characters missing from ROM
+#ifndef I2C_LCD_UTF8_BASE
+#define I2C_LCD_UTF8_BASE       0
+#endif
+
+#ifndef I2C_LCD_UTF8_SLOTS
+#define I2C_LCD_UTF8_SLOTS      (8 - I2C_LCD_UTF8_BASE)
+#endif
+
+#define MISSING                 0x00 // no ROM code in the tables below
+
+/**
+ ******************************************************************************
+ * ROM codes of U+00A0 to U+00FF (Latin-1 supplement)
+ ******************************************************************************
+ */
+#if I2C_LCD_ROM == I2C_LCD_ROM_A00
+static const uint8_t _latin1[96] = {
+    /* A0 */ 0x20, MISSING, 0xEC, 0xED, MISSING, 0x5C, MISSING, MISSING, 
+    /* A8 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* B0 */ 0xDF, MISSING, MISSING, MISSING, MISSING, 0xE4, MISSING, 0xA5, 
+    /* B8 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* C0 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* C8 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* D0 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* D8 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 0xE2, 
+    /* E0 */ MISSING, MISSING, MISSING, MISSING, 0xE1, MISSING, MISSING, MISSING, 
+    /* E8 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* F0 */ MISSING, 0xEE, MISSING, MISSING, MISSING, MISSING, 0xEF, 0xFD, 
+    /* F8 */ MISSING, MISSING, MISSING, MISSING, 0xF5, MISSING, MISSING, MISSING, 
+};
+
+// ROM codes of U+0391 to U+03C9 (Greek)
+static const uint8_t _greek[57] = {
+    /* 391 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* 399 */ MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* 3A1 */ MISSING, MISSING, 0xF6, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* 3A9 */ 0xF4, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* 3B1 */ 0xE0, 0xE2, MISSING, MISSING, 0xE3, MISSING, MISSING, 0xF2, 
+    /* 3B9 */ MISSING, MISSING, MISSING, 0xE4, MISSING, MISSING, MISSING, 0xF7, 
+    /* 3C1 */ 0xE6, MISSING, 0xE5, MISSING, MISSING, MISSING, MISSING, MISSING, 
+    /* 3C9 */ MISSING, 
+};
+#endif
+
+/**
+ ******************************************************************************
+ * Glyphs for common characters the ROMs do not have.
+ ******************************************************************************
+ */
+static const i2c_lcd_utf8_glyph_t _default_glyphs[] = {
+    { 0x005C, { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00 } }, // backslash
+    { 0x007E, { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00 } }, // ~
+    { 0x00C4, { 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00 } }, // A umlaut
+    { 0x00D6, { 0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } }, // O umlaut
+    { 0x00DC, { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 } }, // U umlaut
+    { 0x00E0, { 0x08, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 } }, // a grave
+    { 0x00E7, { 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x0C } }, // c cedilla
+    { 0x00E8, { 0x08, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } }, // e grave
+    { 0x00E9, { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } }, // e acute
+    { 0x20AC, { 0x06, 0x09, 0x1C, 0x08, 0x1C, 0x09, 0x06, 0x00 } }, // euro
+};
+
+// Private state variables
+const i2c_lcd_utf8_glyph_t *_glyphs = _default_glyphs;
+uint8_t _num_glyphs = sizeof(_default_glyphs) / sizeof(_default_glyphs[0]);
+uint32_t _slot_code[8];                 // code point last put in each location
+uint8_t _next_slot = 0;
+
+/*-------------------------------------------------------------------------- */
+/* Private Function Declarations                                             */ 
+/*---------------------------------------------------------------------------*/
+static uint32_t _i2c_lcd_utf8_decode(const uint8_t *text, uint16_t length, 
+    uint16_t *index);
+static const uint8_t *_i2c_lcd_utf8_glyph(uint32_t code);
+static i2c_lcd_status_t _i2c_lcd_utf8_fallback(uint32_t code, uint8_t reserved, 
+    uint8_t *cell);
+
+/*-------------------------------------------------------------------------- */
+/* UTF-8 API Functions                                                       */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * The text is converted to character codes first, uploading the glyphs of 
+ * characters missing from ROM on the way, then the line is written in one 
+ * i2c_lcd_update.
+ ******************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_print_utf8(uint8_t col, uint8_t row, const uint8_t *text, 
+    uint16_t length) {
+    i2c_lcd_status_t status = I2C_LCD_OK;
+    uint8_t cells[LCD_LINE_SIZE];
+    uint8_t count = 0;
+    uint8_t reserved = 0;   // locations taken by earlier characters of this text
+    uint16_t index = 0;
+    
+    while (index < length && count < LCD_LINE_SIZE && status == I2C_LCD_OK) {
+        uint32_t code = _i2c_lcd_utf8_decode(text, length, &index);
+        uint8_t cell = I2C_LCD_UTF8_UNKNOWN;
+        if (!i2c_lcd_utf8_to_rom(code, &cell)) {
+            status = _i2c_lcd_utf8_fallback(code, reserved, &cell);
+            if (cell < 8) {
+                reserved |= 1 << cell;
+            }
+        }
+        cells[count++] = cell;
+    }
+    if (status == I2C_LCD_OK) {
+        status = i2c_lcd_update(col, row, cells, count);
+    }
+    return status;
+}
+
+/**
+ ******************************************************************************
+ * Each block of Unicode the ROM covers has a table (or a fixed offset) indexed 
+ * by the code point, the handful of single symbols are a switch.
+ ******************************************************************************
+ */
+bool i2c_lcd_utf8_to_rom(uint32_t code, uint8_t *rom) {
+    uint8_t value = MISSING;
+#if I2C_LCD_ROM == I2C_LCD_ROM_A00
+    // A00 has a yen sign and arrows in place of the backslash and tilde
+    if (code >= 0x20 && code <= 0x7D && code != 0x5C) {
+        value = code;
+    } else if (code >= 0xA0 && code <= 0xFF) {
+        value = _latin1[code - 0xA0];
+    } else if (code >= 0x391 && code <= 0x3C9) {
+        value = _greek[code - 0x391];
+    } else if (code >= 0xFF61 && code <= 0xFF9F) {
+        // Half width katakana are in Unicode order
+        value = code - 0xFF61 + 0xA1;
+    } else {
+        switch (code) {
+            case 0x2190: value = 0x7F; break; // left arrow
+            case 0x2192: value = 0x7E; break; // right arrow
+            case 0x221A: value = 0xE8; break; // square root
+            case 0x221E: value = 0xF3; break; // infinity
+            case 0x2588: value = 0xFF; break; // full block
+            case 0x3001: value = 0xA4; break; // ideographic comma
+            case 0x3002: value = 0xA1; break; // ideographic full stop
+            case 0x300C: value = 0xA2; break; // corner brackets
+            case 0x300D: value = 0xA3; break;
+            case 0x30FB: value = 0xA5; break; // katakana middle dot
+            case 0x4E07: value = 0xFB; break; // 10 thousand
+            case 0x5343: value = 0xFA; break; // thousand
+            case 0x5186: value = 0xFC; break; // yen
+            default: break;
+        }
+    }
+#else
+    // A02 follows ASCII and then ISO 8859-1 from 0xA0
+    if (code >= 0x20 && code <= 0x7E) {
+        value = code;
+    } else if (code == 0xA0) {
+        value = ' ';
+    } else if (code > 0xA0 && code <= 0xFF) {
+        value = code;
+    } else if (code == 0x2588) {
+        value = 0xFF;
+    }
+#endif
+    if (value == MISSING) {
+        return false;
+    }
+    *rom = value;
+    return true;
+}
+
+void i2c_lcd_utf8_set_glyphs(const i2c_lcd_utf8_glyph_t *glyphs, uint8_t count) {
+    _glyphs = glyphs;
+    _num_glyphs = count;
+}
+
+/*-------------------------------------------------------------------------- */
+/* Private Functions                                                         */ 
+/*---------------------------------------------------------------------------*/
+
+/**
+ ******************************************************************************
+ * Private function that decodes one UTF-8 sequence.
+ * 
+ * @param[in]     text    UTF-8 text
+ * @param[in]     length  length of text in bytes
+ * @param[in,out] index   start of the sequence, moved past it
+ * @return code point, 0xFFFD for a malformed sequence
+ ******************************************************************************
+ */
+static uint32_t _i2c_lcd_utf8_decode(const uint8_t *text, uint16_t length, 
+    uint16_t *index) {
+    uint8_t lead = text[(*index)++];
+    uint8_t extra;
+    uint32_t code;
+    
+    if (lead < 0x80) {
+        return lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        code = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        code = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        code = lead & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+    while (extra-- > 0) {
+        if (*index >= length || (text[*index] & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        code = (code << 6) | (text[(*index)++] & 0x3F);
+    }
+    return code;
+}
+
+/**
+ ******************************************************************************
+ * Private function that finds the glyph of a code point, NULL if there is none.
+ ******************************************************************************
+ */
+static const uint8_t *_i2c_lcd_utf8_glyph(uint32_t code) {
+    for (uint8_t i = 0; i < _num_glyphs; i++) {
+        if (_glyphs[i].code == code) {
+            return _glyphs[i].charmap;
+        }
+    }
+    return NULL;
+}
+
+/**
+ ******************************************************************************
+ * Private function that puts the glyph of a character missing from ROM in 
+ * CGRAM. A location that last held the same character is used again if it 
+ * still holds the glyph or is off screen: it may have been given another 
+ * glyph since, which the upload must not replace on screen. Otherwise the 
+ * next location that is neither on screen nor used earlier in the same text. 
+ * [cell] is left as I2C_LCD_UTF8_UNKNOWN when there is no glyph or no free 
+ * location.
+ * 
+ * @param[in]  code      code point
+ * @param[in]  reserved  bit per location that must not be replaced
+ * @param[out] cell      character code to print
+ ******************************************************************************
+ */
+static i2c_lcd_status_t _i2c_lcd_utf8_fallback(uint32_t code, uint8_t reserved, 
+    uint8_t *cell) {
+    const uint8_t *charmap = _i2c_lcd_utf8_glyph(code);
+    if (charmap == NULL) {
+        return I2C_LCD_OK;
+    }
+    
+    for (uint8_t i = 0; i < I2C_LCD_UTF8_SLOTS; i++) {
+        uint8_t location = (I2C_LCD_UTF8_BASE + i) & 0x07;
+        if (_slot_code[location] == code && (i2c_lcd_char_matches(location, charmap) || 
+            !i2c_lcd_char_on_screen(location))) {
+            *cell = location;
+            return i2c_lcd_create_char(location, charmap);
+        }
+    }
+    for (uint8_t i = 0; i < I2C_LCD_UTF8_SLOTS; i++) {
+        uint8_t location = (I2C_LCD_UTF8_BASE + 
+            (_next_slot + i) % I2C_LCD_UTF8_SLOTS) & 0x07;
+        if (!(reserved & (1 << location)) && !i2c_lcd_char_on_screen(location)) {
+            _next_slot = (_next_slot + i + 1) % I2C_LCD_UTF8_SLOTS;
+            _slot_code[location] = code;
+            *cell = location;
+            return i2c_lcd_create_char(location, charmap);
+        }
+    }
+    return I2C_LCD_OK;
+}
@@ -0,0 +1,119 @@
+/**
+ ****************************************************************************************
+ *
+ * @file    i2c_lcd_utf8.h
+ * @brief   UTF-8 text for the I2C LCD driver.
+ *
+ * MIT License
+ * 
+ * Copyright (c) 2023 James Ehly
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ****************************************************************************************
+ */
+
+
+#ifndef _I2C_LCD_UTF8_H_
+#define _I2C_LCD_UTF8_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_lcd.h"
+
+/**
+ ****************************************************************************************
+ * CONFIG DEFINES
+ ****************************************************************************************
+ */
+// Character ROM of the controller, set I2C_LCD_ROM to one of these
+#define I2C_LCD_ROM_A00         0   // Japanese (katakana), the common one
+#define I2C_LCD_ROM_A02         1   // European
+
+/*
+ * TYPE DEFINITIONS
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * Bitmap for a character that is not in the character ROM.
+ ****************************************************************************************
+ */
+typedef struct {
+    uint32_t code;              // Unicode code point
+    uint8_t charmap[8];
+} i2c_lcd_utf8_glyph_t;
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+ /**
+ ****************************************************************************************
+ * Prints UTF-8 text at col and row.
+ *
+ * Characters are looked up in the ROM tables of I2C_LCD_ROM in constant time. A
+ * character that is not in ROM but has a glyph (see i2c_lcd_utf8_set_glyphs) is put in
+ * a free CGRAM location, one that is not on screen, the first time it is used.
+ * Anything else, and malformed UTF-8, prints as I2C_LCD_UTF8_UNKNOWN ('?').
+ *
+ * The text is written with i2c_lcd_update so unchanged cells cost nothing. Cost per
+ * character that changed, in expander bytes:
+ *  - in ROM or a glyph already in CGRAM:   6
+ *  - glyph uploaded to CGRAM:              6 + 60 (CGRAM address, 8 rows and the
+ *                                          DDRAM address again)
+ *
+ * @param[in] col    column number, zero indexed
+ * @param[in] row    row number, zero indexed
+ * @param[in] text   UTF-8 text
+ * @param[in] length length of text in bytes
+ ****************************************************************************************
+ */
+i2c_lcd_status_t i2c_lcd_print_utf8(uint8_t col, uint8_t row, const uint8_t *text, 
+    uint16_t length);
+
+ /**
+ ****************************************************************************************
+ * Looks up a code point in the character ROM
+ *
+ * @param[in]  code Unicode code point
+ * @param[out] rom  character code in ROM
+ * @return false if the character is not in ROM
+ ****************************************************************************************
+ */
+bool i2c_lcd_utf8_to_rom(uint32_t code, uint8_t *rom);
+
+ /**
+ ****************************************************************************************
+ * Sets the glyphs used for characters that are not in ROM, replacing the built-in set
+ * (a few accented letters, '\', '~' and the euro sign).
+ *
+ * @param[in] glyphs glyph table, must stay valid
+ * @param[in] count  number of glyphs
+ ****************************************************************************************
+ */
+void i2c_lcd_utf8_set_glyphs(const i2c_lcd_utf8_glyph_t *glyphs, uint8_t count);
+
+#endif // _I2C_LCD_UTF8_H_